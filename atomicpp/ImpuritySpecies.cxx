@@ -111,29 +111,29 @@ void ImpuritySpecies::makeRateCoefficients(){
 	}
 };
 // Accessor functions
-	string ImpuritySpecies::get_symbol(){
+	string ImpuritySpecies::get_symbol() const{
 		return symbol;
 	};
-	string ImpuritySpecies::get_name(){
+	string ImpuritySpecies::get_name() const{
 		return name;
 	};
-	int ImpuritySpecies::get_year(){
+	int ImpuritySpecies::get_year() const{
 		return year;
 	};
-	bool ImpuritySpecies::get_has_charge_exchange(){
+	bool ImpuritySpecies::get_has_charge_exchange() const{
 		return has_charge_exchange;
 	};
-	int ImpuritySpecies::get_atomic_number(){
+	int ImpuritySpecies::get_atomic_number() const{
 		return atomic_number;
 	};
-	map<string,string> ImpuritySpecies::get_adas_files_dict(){
+	map<string,string> ImpuritySpecies::get_adas_files_dict() const{
 		return adas_files_dict;
 	};
-	map<string,shared_ptr<RateCoefficient> > ImpuritySpecies::get_rate_coefficients(){
+	map<string,shared_ptr<RateCoefficient> > ImpuritySpecies::get_rate_coefficients() const{
 		return rate_coefficients;
 	};
-	shared_ptr<RateCoefficient> ImpuritySpecies::get_rate_coefficient(const string& key){
-		return rate_coefficients[key];
+	shared_ptr<RateCoefficient> ImpuritySpecies::get_rate_coefficient(const string& key) const{
+		return rate_coefficients.at(key);
 	};
 // Accessing environment variables (shared by any function which calls the ImpuritySpecies.hpp header) -- shared functions
 	string get_json_database_path() {
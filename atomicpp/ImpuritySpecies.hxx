@@ -49,21 +49,22 @@ public:
    *
    */
   void makeRateCoefficients();
-  std::string get_symbol();
-  std::string get_name();
-  int get_year();
-  bool get_has_charge_exchange();
-  int get_atomic_number();
-  std::map<std::string, std::string> get_adas_files_dict();
-  std::map<std::string, shared_ptr<RateCoefficient>> get_rate_coefficients();
+  std::string get_symbol() const;
+  std::string get_name() const;
+  int get_year() const;
+  bool get_has_charge_exchange() const;
+  int get_atomic_number() const;
+  std::map<std::string, std::string> get_adas_files_dict() const;
+  std::map<std::string, shared_ptr<RateCoefficient>> get_rate_coefficients() const;
   /**
    * @brief Accesses the value of the rate_coefficient map corresponding
    * to the supplied string key
    *
    * @param key string corresponding to a physics_process
    * @return shared (smart) pointer to a RateCoefficient object
+   * @throws std::out_of_range if there is no rate coefficient for key
    */
-  shared_ptr<RateCoefficient> get_rate_coefficient(const std::string &key);
+  shared_ptr<RateCoefficient> get_rate_coefficient(const std::string &key) const;
 
 private:
   // Data fields
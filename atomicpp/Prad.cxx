@@ -11,9 +11,9 @@
 //
 
 // Include declarations
+#include <cmath>
 #include <fstream>
 #include <iostream>
-#include <set>
 #include <stdexcept> //For error-throwing
 #include <string>
 #include <vector>
@@ -25,12 +25,25 @@
 
 using namespace std;
 
-double computeRadiatedPower(ImpuritySpecies &impurity, double Te, double Ne,
+double computeRadiatedPower(const ImpuritySpecies &impurity, double Te, double Ne,
                             double Ni, double Nn) {
-  
+  return computeRadiatedPowerLog10(impurity, log10(Te < 1e-5 ? 1e-5 : Te),
+                                   log10(Ne < 1e-5 ? 1e-5 : Ne), Ne, Ni, Nn);
+}
+
+double computeRadiatedPowerLog10(const ImpuritySpecies &impurity, double log10_Te,
+                                 double log10_Ne, double Ne, double Ni, double Nn) {
+
   int Z = impurity.get_atomic_number();
   vector<double> iz_stage_distribution(Z + 1);
 
+  // Get the RateCoefficients from the rate_coefficient map (attribute of
+  // impurity) once, rather than for each charge state
+  const shared_ptr<RateCoefficient> iz_rate_coefficient =
+      impurity.get_rate_coefficient("ionisation");
+  const shared_ptr<RateCoefficient> rec_rate_coefficient =
+      impurity.get_rate_coefficient("recombination");
+
   // Set GS density equal to 1 (arbitrary)
   iz_stage_distribution[0] = 1;
   double sum_iz = 1;
@@ -38,21 +51,9 @@ double computeRadiatedPower(ImpuritySpecies &impurity, double Te, double Ne,
   // Loop over 0, 1, ..., Z-1
   // Each charge state is set in terms of the density of the previous
   for (int k = 0; k < Z; ++k) {
-    // Ionisation
-    // Get the RateCoefficient from the rate_coefficient map (atrribute of
-    // impurity)
-    shared_ptr<RateCoefficient> iz_rate_coefficient =
-        impurity.get_rate_coefficient("ionisation");
-    // Evaluate the RateCoefficient at the point
-    double k_iz_evaluated = iz_rate_coefficient->call0D(k, Te, Ne);
-
-    // Recombination
-    // Get the RateCoefficient from the rate_coefficient map (atrribute of
-    // impurity)
-    shared_ptr<RateCoefficient> rec_rate_coefficient =
-        impurity.get_rate_coefficient("recombination");
-    // Evaluate the RateCoefficient at the point
-    double k_rec_evaluated = rec_rate_coefficient->call0D(k, Te, Ne);
+    // Evaluate the RateCoefficients at the point
+    double k_iz_evaluated = iz_rate_coefficient->call0D_log10(k, log10_Te, log10_Ne);
+    double k_rec_evaluated = rec_rate_coefficient->call0D_log10(k, log10_Te, log10_Ne);
 
     // The ratio of ionisation from the (k)th stage and recombination from the
     // (k+1)th sets the equilibrium densities
@@ -76,70 +77,40 @@ double computeRadiatedPower(ImpuritySpecies &impurity, double Te, double Ne,
     iz_stage_distribution[k] = iz_stage_distribution[k] / sum_iz;
   }
 
-  set<string> radiative_processes = {"line_power", "continuum_power"};
-  if (impurity.get_has_charge_exchange()) {
-    radiative_processes.insert("cx_power");
-  }
+  const shared_ptr<RateCoefficient> line_power =
+      impurity.get_rate_coefficient("line_power");
+  const shared_ptr<RateCoefficient> continuum_power =
+      impurity.get_rate_coefficient("continuum_power");
+  const bool has_cx = impurity.get_has_charge_exchange();
+  const shared_ptr<RateCoefficient> cx_power =
+      has_cx ? impurity.get_rate_coefficient("cx_power") : nullptr;
 
   double total_power = 0;
 
   for (int k = 0; k < Z; ++k) {
-    double k_power = 0;
-    for (set<string>::iterator iter = radiative_processes.begin();
-         iter != radiative_processes.end(); ++iter) {
-
-      shared_ptr<RateCoefficient> rate_coefficient =
-          impurity.get_rate_coefficient(*iter);
-      double k_evaluated = rate_coefficient->call0D(k, Te, Ne);
-
-      double scale;
-      int target_charge_state;
-
-      if (*iter == "line_power") {
-        //# range of k is 0 to (Z-1)+ (needs bound electrons)
-        target_charge_state = k; //#electron-bound target
-        //# Prad = L * Ne * Nz^k+
-        //#      = L * scale
-        // N.b. Ne is function input
-        double Nz_charge_state =
-            Ni * iz_stage_distribution[target_charge_state];
-        scale = Ne * Nz_charge_state;
-
-      } else if (*iter == "continuum_power") {
-        //# range of k is 1+ to Z+ (needs charged target)
-        target_charge_state = k + 1; //#charged target
-        //# Prad = L * Ne * Nz^(k+1)
-        //#      = L * scale
-        // N.b. Ne is function input
-        double Nz_charge_state =
-            Ni * iz_stage_distribution[target_charge_state];
-        scale = Ne * Nz_charge_state;
-      } else if (*iter == "cx_power") {
-        //# range of k is 1+ to Z+ (needs charged target)
-        target_charge_state = k + 1; //#charged target
-        //# Prad = L * n_0 * Nz^(k+1)+
-        //#      = L * scale
-        // N.b. Nn is function input
-        double Nz_charge_state =
-            Ni * iz_stage_distribution[target_charge_state];
-        scale = Nn * Nz_charge_state;
-      } else {
-        throw invalid_argument(
-            "radiative_process not recognised (in computeRadiatedPower)");
-      }
-      double power = scale * k_evaluated;
-      // N.b. These won't quite give the power from the kth charge state.
-      // Instead they give the
-      // power from the kth element on the rate coefficient, which may be kth or
-      // (k+1)th charge state
-      k_power += power;
+    // N.b. These won't quite give the power from the kth charge state.
+    // Instead they give the power from the kth element on the rate
+    // coefficient, which may be kth or (k+1)th charge state
+
+    //# Line power: range of k is 0 to (Z-1)+ (needs bound electrons)
+    //# Prad = L * Ne * Nz^k+
+    double k_power =
+        line_power->call0D_log10(k, log10_Te, log10_Ne) * Ne * Ni *
+        iz_stage_distribution[k];
+
+    //# Continuum power: range of k is 1+ to Z+ (needs charged target)
+    //# Prad = L * Ne * Nz^(k+1)
+    k_power += continuum_power->call0D_log10(k, log10_Te, log10_Ne) * Ne * Ni *
+               iz_stage_distribution[k + 1];
+
+    if (has_cx) {
+      //# CX power: range of k is 1+ to Z+ (needs charged target)
+      //# Prad = L * n_0 * Nz^(k+1)+
+      k_power +=
+          cx_power->call0D_log10(k, log10_Te, log10_Ne) * Nn * Ni *
+          iz_stage_distribution[k + 1];
     }
-    // N.b. These won't quite give the power from the kth charge state. Instead
-    // they give the
-    // power from the kth element on the rate coefficient, which may be kth or
-    // (k+1)th charge state
-    // cout << "Total power from all procs. from k="<<k<<" is "<<k_power<<"
-    // [W/m3]\n"<<endl;
+
     total_power += k_power;
   }
 
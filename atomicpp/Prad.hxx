@@ -34,8 +34,16 @@
 ///
 /// double total_power = computeRadiatedPower(impurity, Te, Ne, Ni, Nn);
 ///
-double computeRadiatedPower(ImpuritySpecies &impurity, double Te, double Ne,
+/// Safe to call from several threads at once with the same impurity
+///
+double computeRadiatedPower(const ImpuritySpecies &impurity, double Te, double Ne,
                             double Ni, double Nn);
 
+/// As computeRadiatedPower, but with log10 of Te [eV] and Ne [m^-3]
+/// already taken, so that they are shared by all rates at a point.
+/// The logs are used for all rate coefficients, Ne for the powers
+double computeRadiatedPowerLog10(const ImpuritySpecies &impurity, double log10_Te,
+                                 double log10_Ne, double Ne, double Ni, double Nn);
+
 #endif // __ATOMICPP_PRAD_H__
 
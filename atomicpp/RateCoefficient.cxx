@@ -39,7 +39,7 @@ ostream& operator<<(ostream& os, const RateCoefficient& RC){
     os << "RateCoefficient object from " << RC.adf11_file << endl;
     return os;  
 }
-double RateCoefficient::call0D(const int k, const double eval_Te, const double eval_Ne){
+double RateCoefficient::call0D(const int k, const double eval_Te, const double eval_Ne) const{
 
 	// """Evaluate the ionisation/recombination coefficients of
 	// 	k'th atomic state at a given temperature and density.
@@ -51,11 +51,12 @@ double RateCoefficient::call0D(const int k, const double eval_Te, const double e
 	// 	Returns:
 	// 		c (double): Rate coefficent in [m3/s].
 	
+	return call0D_log10(k, log10(eval_Te < 1e-5 ? 1e-5 : eval_Te),
+	                    log10(eval_Ne < 1e-5 ? 1e-5 : eval_Ne));
+};
+double RateCoefficient::call0D_log10(const int k, double eval_log10_Te, double eval_log10_Ne) const{
 	// Perform a basic interpolation based on linear distance
 	// values to search for
-  
-  double eval_log10_Te = log10(eval_Te < 1e-5 ? 1e-5 : eval_Te);
-  double eval_log10_Ne = log10(eval_Ne < 1e-5 ? 1e-5 : eval_Ne);
 	// Look through the log_temperature and log_density attributes of RateCoefficient to find nearest (strictly lower)
 	// Subtract 1 from answer to account for indexing from 0
 	int low_Te = lower_bound(log_temperature.begin(), log_temperature.end(), eval_log10_Te) - log_temperature.begin() - 1;
@@ -65,23 +66,23 @@ double RateCoefficient::call0D(const int k, const double eval_Te, const double e
         // An easy error to make is supplying the function arguments already having taken the log10
         if (low_Te >= static_cast<int>(log_temperature.size())-1) {
           // Te out of bounds on high side
+          te_clamped.fetch_add(1, std::memory_order_relaxed);
 
-          if (!warned_te_range) {
+          if (!warned_te_range.exchange(true)) {
             // Print warning the first time this occurs
             std::cerr << "WARNING (Atomicpp::RateCoefficient): log Te too high (" <<  eval_log10_Te << " > " << *log_temperature.rbegin() << ")\n";
-            std::cerr << "Te, Ne: " << eval_Te << ", " << eval_Ne << endl;
-            warned_te_range = true;
+            std::cerr << "log10 Te, Ne: " << eval_log10_Te << ", " << eval_log10_Ne << endl;
           }
           eval_log10_Te = *log_temperature.rbegin(); // Last element
           low_Te = log_temperature.size()-2;
           
         } else if (low_Te <= -1) {
           // Te out of bounds on low side
+          te_clamped.fetch_add(1, std::memory_order_relaxed);
 
-          if (!warned_te_range) {
+          if (!warned_te_range.exchange(true)) {
             std::cerr << "WARNING (Atomicpp::RateCoefficient): log Te too low (" <<  eval_log10_Te << " < " << *log_temperature.begin() << ")\n";
-            std::cerr << "Te, Ne: " << eval_Te << ", " << eval_Ne << endl;
-            warned_te_range = true;
+            std::cerr << "log10 Te, Ne: " << eval_log10_Te << ", " << eval_log10_Ne << endl;
           }
           eval_log10_Te = *log_temperature.begin();
           low_Te = 0;
@@ -89,20 +90,20 @@ double RateCoefficient::call0D(const int k, const double eval_Te, const double e
         
 	if (low_Ne >= static_cast<int>(log_density.size())-1) {
           // Ne out of bounds on high side
-          if (!warned_ne_range) {
+          ne_clamped.fetch_add(1, std::memory_order_relaxed);
+          if (!warned_ne_range.exchange(true)) {
             std::cerr << "WARNING (Atomicpp::RateCoefficient): log Ne too high (" <<  eval_log10_Ne << " > " << *log_density.rbegin() << ")\n";
-            std::cerr << "Te, Ne: " << eval_Te << ", " << eval_Ne << endl;
-            warned_ne_range = true;
+            std::cerr << "log10 Te, Ne: " << eval_log10_Te << ", " << eval_log10_Ne << endl;
           }
           eval_log10_Ne = *log_density.rbegin(); // Last element
           low_Ne = log_density.size()-2;
           
         } else if (low_Ne <= -1) {
           // Ne out of bounds on low side
-          if (!warned_ne_range) {
+          ne_clamped.fetch_add(1, std::memory_order_relaxed);
+          if (!warned_ne_range.exchange(true)) {
             std::cerr << "WARNING (Atomicpp::RateCoefficient): log Ne too low (" <<  eval_log10_Ne << " < " << *log_density.begin() << ")\n";
-            std::cerr << "Te, Ne: " << eval_Te << ", " << eval_Ne << endl;
-            warned_ne_range = true;
+            std::cerr << "log10 Te, Ne: " << eval_log10_Te << ", " << eval_log10_Ne << endl;
           }
           eval_log10_Ne = *log_density.begin();
           low_Ne = 0;
@@ -132,21 +133,31 @@ double RateCoefficient::call0D(const int k, const double eval_Te, const double e
 	double eval_coeff = pow(10,eval_log10_coeff);
 	return eval_coeff;
 };
-int RateCoefficient::get_atomic_number(){
+int RateCoefficient::get_atomic_number() const{
 	return atomic_number;
 };
-string RateCoefficient::get_element(){
+string RateCoefficient::get_element() const{
 	return element;
 };
-string RateCoefficient::get_adf11_file(){
+string RateCoefficient::get_adf11_file() const{
 	return adf11_file;
 };
-vector<vector< vector<double> > > RateCoefficient::get_log_coeff(){
+vector<vector< vector<double> > > RateCoefficient::get_log_coeff() const{
 	return log_coeff;
 };
-vector<double> RateCoefficient::get_log_temperature(){
+vector<double> RateCoefficient::get_log_temperature() const{
 	return log_temperature;
 };
-vector<double> RateCoefficient::get_log_density(){
+vector<double> RateCoefficient::get_log_density() const{
 	return log_density;
 };
+long RateCoefficient::get_te_clamped() const{
+	return te_clamped.load();
+};
+long RateCoefficient::get_ne_clamped() const{
+	return ne_clamped.load();
+};
+void RateCoefficient::reset_clamp_counts(){
+	te_clamped = 0;
+	ne_clamped = 0;
+};
@@ -1,5 +1,6 @@
 #ifndef RATECOEFFICIENT_H
 #define RATECOEFFICIENT_H
+	#include <atomic>
 	#include <string>
 	#include <vector>
 	#include <fstream>
@@ -35,20 +36,33 @@
 			 * @details Performs a simple bivariate (multilinear) interpolation to return the rate coefficient
 			 * at the supplied Te and Ne values. N.b. will throw a runtime_error if the supplied Te or Ne
 			 * value are not on the interpolating grid (otherwise you'll get a seg fault)
+			 * Safe to call from several threads at once
 			 * 
 			 * @param k The charge state index process (actually k+=1 for charged-target processes, but we don't implement this here)
 			 * @param eval_Te electron temperature (Te) at a point (in eV)
 			 * @param eval_Ne electron density (Ne) at a point (in m^-3)
 			 * @return eval_coeff evaluated rate coefficient in m^3/s
 			 */
-			double call0D(const int k, const double eval_Te, const double eval_Ne);
+			double call0D(const int k, const double eval_Te, const double eval_Ne) const;
+			/**
+			 * @brief As call0D, but with log10 of Te (in eV) and Ne (in m^-3) already taken,
+			 * so that they can be shared between charge states and processes
+			 */
+			double call0D_log10(const int k, double eval_log10_Te, double eval_log10_Ne) const;
 			friend ostream& operator<<(ostream& os, const RateCoefficient& RC); //Define the __str__ return to cout
-			int get_atomic_number();
-			string get_element();
-			string get_adf11_file();
-			vector<vector< vector<double> > > get_log_coeff();
-			vector<double> get_log_temperature();
-			vector<double> get_log_density();
+			int get_atomic_number() const;
+			string get_element() const;
+			string get_adf11_file() const;
+			vector<vector< vector<double> > > get_log_coeff() const;
+			vector<double> get_log_temperature() const;
+			vector<double> get_log_density() const;
+			/**
+			 * @brief Number of times Te or Ne has been outside the table and clamped
+			 * in call0D, since construction or the last reset_clamp_counts()
+			 */
+			long get_te_clamped() const;
+			long get_ne_clamped() const;
+			void reset_clamp_counts();
 		private:
 			int atomic_number;
 			string element;
@@ -56,7 +70,10 @@
 			vector<vector< vector<double> > > log_coeff;
 			vector<double> log_temperature;
 			vector<double> log_density;
-          bool warned_te_range = false; // If a warning about Te range has been printed
-          bool warned_ne_range = false; // If a warning about Ne range has been printed
+          // Changed by call0D, so atomic for thread safety
+          mutable std::atomic<bool> warned_te_range{false}; // If a warning about Te range has been printed
+          mutable std::atomic<bool> warned_ne_range{false}; // If a warning about Ne range has been printed
+          mutable std::atomic<long> te_clamped{0}; // Number of times Te was out of range
+          mutable std::atomic<long> ne_clamped{0}; // Number of times Ne was out of range
 		};
 #endif
@@ -0,0 +1,324 @@
+/*
+  Micro-benchmarks of the atomic rate functions and parallel operators
+
+    This file is part of SD1D.
+
+    SD1D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    SD1D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with SD1D.  If not, see <http://www.gnu.org/licenses/>.
+
+  Every benchmark reports "ns_per_cell", the time per evaluation point
+  (Te, Ne pair for the rates, grid cell for the operators). Run from the
+  build directory with
+
+    ./sd1d_bench -d bench --benchmark_out=bench.json --benchmark_out_format=json
+
+  Options not recognised by Google Benchmark are passed to BOUT++.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <bout.hxx>
+#include <bout/mesh.hxx>
+#include <globals.hxx>
+#include <options.hxx>
+
+#include "div_ops.hxx"
+#include "radiation.hxx"
+
+#include "atomicpp/ImpuritySpecies.hxx"
+#include "atomicpp/Prad.hxx"
+#include "atomicpp/RateCoefficient.hxx"
+
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct SweepPoint {
+  BoutReal Te; ///< Electron temperature [eV]
+  BoutReal Ne; ///< Electron density [m^-3]
+};
+
+/// Log-spaced sweep over Te = 0.1 - 1000 eV and Ne = 1e17 - 1e21 m^-3,
+/// covering conditions from the detached target to upstream
+const std::vector<SweepPoint> &sweep() {
+  static std::vector<SweepPoint> points = [] {
+    const int n = 32;
+    std::vector<SweepPoint> result;
+    for (int i = 0; i < n; i++) {
+      for (int j = 0; j < n; j++) {
+        result.push_back({std::pow(10., -1. + 4. * i / (n - 1)),
+                          std::pow(10., 17. + 4. * j / (n - 1))});
+      }
+    }
+    return result;
+  }();
+  return points;
+}
+
+/// Report the mean time per cell in ns
+void setTimePerCell(benchmark::State &state, int ncells) {
+  state.counters["ns_per_cell"] =
+      benchmark::Counter(ncells * 1e-9, benchmark::Counter::kIsIterationInvariantRate
+                                            | benchmark::Counter::kInvert);
+}
+
+/// Time a rate function rate(Te, Ne) over the sweep
+template <typename F>
+void registerRate(const std::string &name, F rate) {
+  benchmark::RegisterBenchmark(name.c_str(), [rate](benchmark::State &state) {
+    const auto &points = sweep();
+    for (auto _ : state) {
+      for (const auto &p : points) {
+        benchmark::DoNotOptimize(rate(p.Te, p.Ne));
+      }
+    }
+    setTimePerCell(state, points.size());
+  });
+}
+
+void registerHydrogenRates() {
+  static HydrogenRadiatedPower hydrogen;
+  registerRate("HydrogenRadiatedPower/ionisation",
+               [](BoutReal Te, BoutReal) { return hydrogen.ionisation(Te); });
+  registerRate("HydrogenRadiatedPower/recombination", [](BoutReal Te, BoutReal Ne) {
+    return hydrogen.recombination(Ne, Te);
+  });
+  registerRate("HydrogenRadiatedPower/chargeExchange",
+               [](BoutReal Te, BoutReal) { return hydrogen.chargeExchange(Te); });
+  registerRate("HydrogenRadiatedPower/excitation",
+               [](BoutReal Te, BoutReal) { return hydrogen.excitation(Te); });
+
+  static UpdatedRadiatedPower updated;
+  registerRate("UpdatedRadiatedPower/ionisation", [](BoutReal Te, BoutReal Ne) {
+    return updated.ionisation(Ne, Te);
+  });
+  registerRate("UpdatedRadiatedPower/ionisation_old",
+               [](BoutReal Te, BoutReal) { return updated.ionisation_old(Te); });
+  registerRate("UpdatedRadiatedPower/recombination", [](BoutReal Te, BoutReal Ne) {
+    return updated.recombination(Ne, Te);
+  });
+  registerRate("UpdatedRadiatedPower/chargeExchange",
+               [](BoutReal Te, BoutReal) { return updated.chargeExchange(Te); });
+  registerRate("UpdatedRadiatedPower/excitation", [](BoutReal Te, BoutReal Ne) {
+    return updated.excitation(Ne, Te);
+  });
+  registerRate("UpdatedRadiatedPower/excitation_old",
+               [](BoutReal Te, BoutReal) { return updated.excitation_old(Te); });
+  registerRate("UpdatedRadiatedPower/Channel_H_2_amjuel", [](BoutReal Te, BoutReal Ne) {
+    return updated.Channel_H_2_amjuel(Te, Ne);
+  });
+  registerRate("UpdatedRadiatedPower/Channel_H_3_amjuel", [](BoutReal Te, BoutReal Ne) {
+    return updated.Channel_H_3_amjuel(Te, Ne);
+  });
+  registerRate("UpdatedRadiatedPower/Channel_H_4_amjuel", [](BoutReal Te, BoutReal Ne) {
+    return updated.Channel_H_4_amjuel(Te, Ne);
+  });
+  registerRate("UpdatedRadiatedPower/Channel_H_5_amjuel", [](BoutReal Te, BoutReal Ne) {
+    return updated.Channel_H_5_amjuel(Te, Ne);
+  });
+  registerRate("UpdatedRadiatedPower/Channel_H_6_amjuel", [](BoutReal Te, BoutReal Ne) {
+    return updated.Channel_H_6_amjuel(Te, Ne);
+  });
+
+  static ExcitedStatePopulations excited;
+  registerRate("ExcitedStatePopulations/evaluate", [](BoutReal Te, BoutReal Ne) {
+    return excited.evaluate(Te, Ne)[0];
+  });
+  registerRate("ExcitedStatePopulations/radiatedPower", [](BoutReal Te, BoutReal Ne) {
+    return excited.radiatedPower(Te, Ne);
+  });
+
+  // All the rates used in a cell, with and without sharing logarithms
+  registerRate("UpdatedRadiatedPower/all", [](BoutReal Te, BoutReal Ne) {
+    return updated.ionisation(Ne, Te) + updated.recombination(Ne, Te)
+           + updated.excitation(Ne, Te) + updated.chargeExchange(Te)
+           + excited.radiatedPower(Te, Ne);
+  });
+  registerRate("UpdatedRadiatedPower/all_LogState", [](BoutReal Te, BoutReal Ne) {
+    const LogState logs(Te, Ne);
+    return updated.ionisation(logs) + updated.recombination(logs)
+           + updated.excitation(logs) + updated.chargeExchange(logs)
+           + excited.radiatedPower(logs);
+  });
+}
+
+/// ADAS rates for each impurity. The species are never destroyed,
+/// because the benchmarks hold references to them
+void registerImpurityRates() {
+  for (std::string symbol : {"c", "n", "ne"}) {
+    auto *impurity = new ImpuritySpecies(symbol);
+
+    std::vector<std::string> keys = {"ionisation", "recombination", "continuum_power",
+                                     "line_power"};
+    if (impurity->get_has_charge_exchange()) {
+      keys.push_back("cx_recc");
+      keys.push_back("cx_power");
+    }
+
+    // All charge states are evaluated in each cell, as in computeRadiatedPower
+    const int Z = impurity->get_atomic_number();
+    for (const auto &key : keys) {
+      RateCoefficient *coefficient = impurity->get_rate_coefficient(key).get();
+      registerRate("RateCoefficient/call0D/" + symbol + "/" + key,
+                   [coefficient, Z](BoutReal Te, BoutReal Ne) {
+                     BoutReal sum = 0.0;
+                     for (int k = 0; k < Z; k++) {
+                       sum += coefficient->call0D(k, Te, Ne);
+                     }
+                     return sum;
+                   });
+    }
+
+    // Impurity fraction 1%, neutral fraction 10%
+    registerRate("computeRadiatedPower/" + symbol, [impurity](BoutReal Te, BoutReal Ne) {
+      return computeRadiatedPower(*impurity, Te, Ne, 0.01 * Ne, 0.1 * Ne);
+    });
+  }
+}
+
+/// Cooling curve table, and the Hutchinson carbon fit it is sampled from.
+/// The table is written to the data directory
+void registerTableRates() {
+  static HutchinsonCarbonRadiation hutchinson;
+  static const RadiatedPower &fit = hutchinson;
+
+  std::string filename =
+      Options::root()["datadir"].withDefault<std::string>("data") + "/cooling_curve.txt";
+  {
+    std::ofstream file(filename);
+    file.precision(12);
+    file << "# Te [eV]  Lz [W m^3] from HutchinsonCarbonRadiation\n";
+    const int n = 100;
+    for (int i = 0; i < n; i++) {
+      BoutReal Te = std::pow(10., -1. + 4. * i / (n - 1));
+      file << Te << " " << fit.power(Te, 1.0, 1.0) << "\n";
+    }
+  }
+  static InterpRadiatedPower table(filename);
+
+  registerRate("HutchinsonCarbonRadiation/power", [](BoutReal Te, BoutReal Ne) {
+    return fit.power(Te, Ne, 0.01 * Ne);
+  });
+  registerRate("InterpRadiatedPower/power", [](BoutReal Te, BoutReal Ne) {
+    return table.power(Te, Ne, 0.01 * Ne);
+  });
+}
+
+/// A 1D mesh along y with ncells cells, created on first use
+Mesh *mesh1D(int ncells) {
+  static std::map<int, Mesh *> meshes;
+
+  auto it = meshes.find(ncells);
+  if (it != meshes.end()) {
+    return it->second;
+  }
+
+  Options &opt = Options::root()["bench_mesh_" + std::to_string(ncells)];
+  opt["nx"] = 1;
+  opt["ny"] = ncells;
+  opt["dx"] = 1.0;
+  opt["dy"] = 1.0 / ncells;
+  opt["ixseps1"] = -1; // Open field lines, with sheath boundaries
+  opt["ixseps2"] = -1;
+
+  Mesh *m = Mesh::create(&opt);
+  m->load();
+  meshes[ncells] = m;
+  return m;
+}
+
+/// Smooth positive profile with a variation of +/- amplitude around 1
+Field3D profile(Mesh *m, BoutReal amplitude) {
+  Field3D result{m};
+  result.allocate();
+  const int ny = m->LocalNy;
+  for (int i = 0; i < m->LocalNx; i++)
+    for (int j = 0; j < ny; j++)
+      for (int k = 0; k < m->LocalNz; k++) {
+        result(i, j, k) = 1.0 + amplitude * std::sin(3.0 * j / ny);
+      }
+  return result;
+}
+
+/// Time a parallel operator op(K, f) on 1D meshes of 100 to 10,000 cells
+template <typename F>
+void registerOperator(const std::string &name, F op) {
+  benchmark::RegisterBenchmark(name.c_str(),
+                               [op](benchmark::State &state) {
+                                 const int ncells = state.range(0);
+                                 Mesh *m = mesh1D(ncells);
+
+                                 // Operators use the global mesh
+                                 Mesh *global_mesh = bout::globals::mesh;
+                                 bout::globals::mesh = m;
+
+                                 Field3D K = profile(m, 0.5);
+                                 Field3D f = profile(m, -0.3);
+                                 for (auto _ : state) {
+                                   Field3D result = op(K, f);
+                                   benchmark::DoNotOptimize(result(0, m->ystart, 0));
+                                 }
+                                 setTimePerCell(state, ncells);
+
+                                 bout::globals::mesh = global_mesh;
+                               })
+      ->RangeMultiplier(10)
+      ->Range(100, 10000);
+}
+
+void registerOperators() {
+  registerOperator("Div_par_diffusion", [](const Field3D &K, const Field3D &f) {
+    return Div_par_diffusion(K, f, true);
+  });
+  registerOperator("Div_par_spitzer", [](const Field3D &, const Field3D &f) {
+    return Div_par_spitzer(1.0, f, true);
+  });
+  registerOperator("Div_par_diffusion_upwind", [](const Field3D &K, const Field3D &f) {
+    return Div_par_diffusion_upwind(K, f, true);
+  });
+  registerOperator("Div_par_diffusion_index", [](const Field3D &, const Field3D &f) {
+    return Div_par_diffusion_index(f, true);
+  });
+  registerOperator("AddedDissipation", [](const Field3D &K, const Field3D &f) {
+    return AddedDissipation(K, K * f, f, true);
+  });
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  // Remove the benchmark options before BOUT++ reads the command line
+  benchmark::Initialize(&argc, argv);
+
+  int status = BoutInitialise(argc, argv);
+  if (status < 0) {
+    return 0; // Help or version requested
+  }
+  if (status > 0) {
+    return status;
+  }
+
+  registerHydrogenRates();
+  registerImpurityRates();
+  registerTableRates();
+  registerOperators();
+
+  benchmark::RunSpecifiedBenchmarks();
+
+  BoutFinalise();
+  return 0;
+}
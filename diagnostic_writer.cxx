@@ -0,0 +1,257 @@
+/*
+    This file is part of SD1D.
+
+    SD1D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    SD1D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with SD1D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "diagnostic_writer.hxx"
+
+#include <bout/mesh.hxx>
+#include <boutcomm.hxx>
+#include <boutexception.hxx>
+#include <globals.hxx>
+#include <output.hxx>
+#include <utils.hxx>
+
+#include <algorithm>
+
+#ifdef NCDF4
+#include <netcdf.h>
+#endif
+
+using bout::globals::mesh;
+
+namespace {
+#ifdef NCDF4
+/// Throw an exception if a NetCDF call failed
+void check(int status, const std::string &what) {
+  if (status != NC_NOERR) {
+    throw BoutException("DiagnosticWriter: %s: %s", what.c_str(), nc_strerror(status));
+  }
+}
+#endif
+} // namespace
+
+DiagnosticWriter::DiagnosticWriter(Options &options) : options(options) {
+  enable = options["enable"]
+               .doc("Write diagnostics to a compressed file, rather than the "
+                    "dump file")
+               .withDefault<bool>(false);
+  std::string names = options["variables"]
+                          .doc("Comma-separated names of diagnostics to save, "
+                               "or all")
+                          .withDefault<std::string>("all");
+  every = options["every"].doc("Save every this many outputs").withDefault<int>(1);
+  ydecimate = options["ydecimate"]
+                  .doc("Save every this many cells in y")
+                  .withDefault<int>(1);
+  float32 = options["float32"].doc("Store as single precision").withDefault<bool>(true);
+  deflate = options["deflate"]
+                .doc("Compression level 0 (none) to 9")
+                .withDefault<int>(4);
+
+  if (trim(names) != "all") {
+    for (const auto &name : strsplit(names, ',')) {
+      selected.push_back(trim(name));
+    }
+  }
+
+  if ((every < 1) || (ydecimate < 1)) {
+    throw BoutException("DiagnosticWriter: every and ydecimate must be >= 1");
+  }
+
+#ifndef NCDF4
+  if (enable) {
+    output_warn.write("\tDiagnostics can't be compressed: BOUT++ built without "
+                      "NetCDF-4. Writing to the dump file\n");
+    enable = false;
+  }
+#endif
+}
+
+DiagnosticWriter::~DiagnosticWriter() {
+#ifdef NCDF4
+  if (ncid >= 0) {
+    nc_close(ncid);
+  }
+#endif
+}
+
+bool DiagnosticWriter::isSelected(const std::string &name) const {
+  return selected.empty()
+         || (std::find(selected.begin(), selected.end(), name) != selected.end());
+}
+
+void DiagnosticWriter::add(Field3D &f, const std::string &name, Datafile &dump) {
+  if (!isSelected(name)) {
+    return;
+  }
+  if (!enable) {
+    dump.addRepeat(f, name);
+    return;
+  }
+
+  Variable var;
+  var.field = &f;
+  var.name = name;
+  var.every = options[name]["every"].withDefault(every);
+  var.ydecimate = options[name]["ydecimate"].withDefault(ydecimate);
+  variables.push_back(var);
+}
+
+void DiagnosticWriter::open() {
+#ifdef NCDF4
+  std::string datadir = Options::root()["datadir"].withDefault<std::string>("data");
+  std::string filename =
+      datadir + "/BOUT.diag." + std::to_string(BoutComm::rank()) + ".nc";
+
+  const bool append = Options::root()["restart"].withDefault<bool>(false)
+                      && Options::root()["append"].withDefault<bool>(false);
+  if (append && (nc_open(filename.c_str(), NC_WRITE, &ncid) == NC_NOERR)) {
+    openExisting(filename);
+    return;
+  }
+
+  check(nc_create(filename.c_str(), NC_NETCDF4 | NC_CLOBBER, &ncid), filename);
+
+  const int nx = mesh->xend - mesh->xstart + 1;
+  const int nz = mesh->LocalNz;
+  int xdim, zdim;
+  check(nc_def_dim(ncid, "x", nx, &xdim), "x dimension");
+  check(nc_def_dim(ncid, "z", nz, &zdim), "z dimension");
+
+  for (auto &var : variables) {
+    define(var, xdim, zdim);
+  }
+  check(nc_enddef(ncid), filename);
+#endif
+}
+
+#ifdef NCDF4
+void DiagnosticWriter::openExisting(const std::string &filename) {
+  const std::size_t nx = mesh->xend - mesh->xstart + 1;
+  const int ny = mesh->yend - mesh->ystart + 1;
+  const std::size_t nz = mesh->LocalNz;
+
+  int xdim, zdim;
+  std::size_t xlen, zlen;
+  check(nc_inq_dimid(ncid, "x", &xdim), filename);
+  check(nc_inq_dimid(ncid, "z", &zdim), filename);
+  check(nc_inq_dimlen(ncid, xdim, &xlen), filename);
+  check(nc_inq_dimlen(ncid, zdim, &zlen), filename);
+  if ((xlen != nx) || (zlen != nz)) {
+    throw BoutException("DiagnosticWriter: %s has a different grid. Can't append",
+                        filename.c_str());
+  }
+
+  bool define_mode = false;
+  for (auto &var : variables) {
+    if (nc_inq_varid(ncid, var.name.c_str(), &var.varid) != NC_NOERR) {
+      // Not saved by the earlier run
+      if (!define_mode) {
+        check(nc_redef(ncid), filename);
+        define_mode = true;
+      }
+      define(var, xdim, zdim);
+      continue;
+    }
+    check(nc_inq_varid(ncid, (var.name + "_time").c_str(), &var.timeid), var.name);
+
+    int tdim, ydim;
+    std::size_t ylen;
+    check(nc_inq_dimid(ncid, (var.name + "_t").c_str(), &tdim), var.name);
+    check(nc_inq_dimid(ncid, (var.name + "_y").c_str(), &ydim), var.name);
+    check(nc_inq_dimlen(ncid, ydim, &ylen), var.name);
+    if (ylen != static_cast<std::size_t>((ny + var.ydecimate - 1) / var.ydecimate)) {
+      throw BoutException("DiagnosticWriter: %s in %s has a different y size. "
+                          "Can't append",
+                          var.name.c_str(), filename.c_str());
+    }
+    check(nc_inq_dimlen(ncid, tdim, &var.records), var.name);
+  }
+  if (define_mode) {
+    check(nc_enddef(ncid), filename);
+  }
+  output_info.write("\tAppending diagnostics to %s\n", filename.c_str());
+}
+
+void DiagnosticWriter::define(Variable &var, int xdim, int zdim) {
+  const int nx = mesh->xend - mesh->xstart + 1;
+  const int nz = mesh->LocalNz;
+  const int ny = mesh->yend - mesh->ystart + 1;
+  int tdim, ydim;
+  check(nc_def_dim(ncid, (var.name + "_t").c_str(), NC_UNLIMITED, &tdim), var.name);
+  check(nc_def_dim(ncid, (var.name + "_y").c_str(),
+                   (ny + var.ydecimate - 1) / var.ydecimate, &ydim),
+        var.name);
+
+  check(nc_def_var(ncid, (var.name + "_time").c_str(), NC_DOUBLE, 1, &tdim,
+                   &var.timeid),
+        var.name);
+
+  // One record is one chunk, so records can be written independently
+  int dims[4] = {tdim, xdim, ydim, zdim};
+  check(nc_def_var(ncid, var.name.c_str(), float32 ? NC_FLOAT : NC_DOUBLE, 4, dims,
+                   &var.varid),
+        var.name);
+  size_t chunks[4] = {1, static_cast<size_t>(nx),
+                      static_cast<size_t>((ny + var.ydecimate - 1) / var.ydecimate),
+                      static_cast<size_t>(nz)};
+  check(nc_def_var_chunking(ncid, var.varid, NC_CHUNKED, chunks), var.name);
+  if (deflate > 0) {
+    check(nc_def_var_deflate(ncid, var.varid, 1, 1, deflate), var.name);
+  }
+  check(nc_put_att_int(ncid, var.varid, "every", NC_INT, 1, &var.every), var.name);
+  check(nc_put_att_int(ncid, var.varid, "ydecimate", NC_INT, 1, &var.ydecimate),
+        var.name);
+}
+#endif
+
+void DiagnosticWriter::write(BoutReal simtime, int iter) {
+#ifdef NCDF4
+  if (!enable || variables.empty()) {
+    return;
+  }
+  if (ncid < 0) {
+    open();
+  }
+
+  std::vector<double> data;
+  for (auto &var : variables) {
+    if (iter % var.every != 0) {
+      continue;
+    }
+
+    const Field3D &f = *var.field;
+    data.clear();
+    for (int i = mesh->xstart; i <= mesh->xend; i++)
+      for (int j = mesh->ystart; j <= mesh->yend; j += var.ydecimate)
+        for (int k = 0; k < mesh->LocalNz; k++) {
+          data.push_back(f(i, j, k));
+        }
+
+    const int ny = (mesh->yend - mesh->ystart) / var.ydecimate + 1;
+    size_t start[4] = {var.records, 0, 0, 0};
+    size_t count[4] = {1, static_cast<size_t>(mesh->xend - mesh->xstart + 1),
+                       static_cast<size_t>(ny), static_cast<size_t>(mesh->LocalNz)};
+    check(nc_put_vara_double(ncid, var.varid, start, count, data.data()), var.name);
+    check(nc_put_vara_double(ncid, var.timeid, start, count, &simtime), var.name);
+    var.records++;
+  }
+  check(nc_sync(ncid), "sync");
+#else
+  (void)simtime;
+  (void)iter;
+#endif
+}
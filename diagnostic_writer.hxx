@@ -0,0 +1,104 @@
+/*
+  Compressed output of diagnostic fields, with per-variable frequency
+  and y decimation
+
+    This file is part of SD1D.
+
+    SD1D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    SD1D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with SD1D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __DIAGNOSTIC_WRITER_H__
+#define __DIAGNOSTIC_WRITER_H__
+
+#include <bout_types.hxx>
+#include <datafile.hxx>
+#include <field3d.hxx>
+#include <options.hxx>
+
+#include <string>
+#include <vector>
+
+/*!
+ * Writes diagnostic fields to a separate NetCDF-4 file on each processor,
+ * <datadir>/BOUT.diag.<rank>.nc, rather than the dump file. Settings are
+ * in the [diagnostics] section:
+ *
+ *   enable     Use this writer. If false, fields are added to the dump file
+ *   variables  Comma-separated names of fields to save, or "all"
+ *   every      Save every this many outputs
+ *   ydecimate  Save every this many cells in y
+ *   float32    Store as single precision
+ *   deflate    Compression level 0 (none) to 9
+ *
+ * every and ydecimate can be set for each field in [diagnostics:<name>].
+ * Each field has its own unlimited time dimension, <name>_t, and the
+ * simulation time of each record is saved in <name>_time.
+ *
+ * As for the dump file, when restarting with append = true records are
+ * added to the existing file. Otherwise the file is replaced.
+ *
+ * Requires BOUT++ to be built with NetCDF-4 (NCDF4). Otherwise fields
+ * which are selected are added to the dump file, as if enable = false.
+ */
+class DiagnosticWriter {
+public:
+  /// Read settings from options, usually Options::root()["diagnostics"]
+  explicit DiagnosticWriter(Options &options);
+  ~DiagnosticWriter();
+
+  DiagnosticWriter(const DiagnosticWriter &) = delete;
+  DiagnosticWriter &operator=(const DiagnosticWriter &) = delete;
+
+  /// Add a field to be saved. The field must exist until the
+  /// writer is destroyed. Fields not in "variables" are ignored
+  void add(Field3D &f, const std::string &name, Datafile &dump);
+
+  /// Save the fields due at output number iter
+  void write(BoutReal simtime, int iter);
+
+private:
+  struct Variable {
+    Field3D *field;
+    std::string name;
+    int every;     ///< Outputs between records
+    int ydecimate; ///< Cells in y between saved points
+    int varid{-1}, timeid{-1}; ///< NetCDF IDs of the data and time
+    std::size_t records{0};    ///< Number of records written
+  };
+
+  bool enable;
+  std::vector<std::string> selected; ///< Empty for all
+  int every, ydecimate;
+  bool float32;
+  int deflate;
+
+  Options &options;
+  std::vector<Variable> variables;
+
+  int ncid{-1}; ///< File ID, or -1 if not open
+
+  bool isSelected(const std::string &name) const;
+
+  /// Open the file and define all variables, on the first write
+  void open();
+
+  /// Find the variables in an existing file, and the number of records
+  /// of each. Variables not in the file are defined
+  void openExisting(const std::string &filename);
+
+  /// Define a variable and its time in the file, in define mode
+  void define(Variable &var, int xdim, int zdim);
+};
+
+#endif // __DIAGNOSTIC_WRITER_H__
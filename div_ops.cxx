@@ -28,17 +28,49 @@
 #include <output.hxx>
 #include <utils.hxx>
 #include <bout/assert.hxx>
+#include <bout/openmpwrap.hxx>
 
 #include <cmath>
 
 using bout::globals::mesh;
 
-const Field3D Div_par_diffusion(const Field3D &K, const Field3D &f, bool bndry_flux) {
+namespace {
+/// Divergence of the fluxes through the upper face of cells ystart-1 to yend.
+/// The flux through the face between cells j and j+1 is stored in flux(i,j,k).
+/// If divide_dy is false, the difference is divided by J rather than dy*J.
+///
+/// Each cell takes the difference of its two face fluxes, rather than each
+/// flux being added to both neighbouring cells, so that cells can be
+/// calculated in parallel. The order of operations is unchanged.
+const Field3D fluxDivergence(const Field3D &flux, bool divide_dy) {
   Field3D result;
   result = 0.0;
+
+  Coordinates *coord = mesh->getCoordinates();
+
+  BOUT_OMP(parallel for collapse(3) schedule(static))
+  for(int i=mesh->xstart;i<=mesh->xend;i++)
+    for(int j=mesh->ystart-1;j<=mesh->yend+1;j++)
+      for(int k=0;k<mesh->LocalNz;k++) {
+        BoutReal volume = divide_dy ? coord->dy(i,j) * coord->J(i,j) : coord->J(i,j);
+        BoutReal div = 0.0;
+        if(j >= mesh->ystart)
+          div -= flux(i,j-1,k) / volume; // Lower face
+        if(j <= mesh->yend)
+          div += flux(i,j,k) / volume; // Upper face
+        result(i,j,k) = div;
+      }
+  return result;
+}
+} // namespace
+
+const Field3D Div_par_diffusion(const Field3D &K, const Field3D &f, bool bndry_flux) {
+  Field3D flux;
+  flux = 0.0;
   
   Coordinates *coord = mesh->getCoordinates();
   
+  BOUT_OMP(parallel for collapse(3) schedule(static))
   for(int i=mesh->xstart;i<=mesh->xend;i++)
     for(int j=mesh->ystart-1;j<=mesh->yend;j++)
       for(int k=0;k<mesh->LocalNz;k++) {
@@ -61,20 +93,18 @@ const Field3D Div_par_diffusion(const Field3D &K, const Field3D &f, bool bndry_f
         
         BoutReal gradient = 2.*(f(i,j+1,k) - f(i,j,k)) / (coord->dy(i,j) + coord->dy(i,j+1));
         
-        BoutReal flux = c * J * gradient / g_22;
-        
-        result(i,j,k) += flux / (coord->dy(i,j) * coord->J(i,j));
-        result(i,j+1,k) -= flux / (coord->dy(i,j+1) * coord->J(i,j+1));
+        flux(i,j,k) = c * J * gradient / g_22;
       }
-  return result;
+  return fluxDivergence(flux, true);
 }
 
 const Field3D Div_par_spitzer(BoutReal K0, const Field3D &Te, bool bndry_flux) {
-  Field3D result;
-  result = 0.0;
+  Field3D flux;
+  flux = 0.0;
 
   Coordinates *coord = mesh->getCoordinates();
 
+  BOUT_OMP(parallel for collapse(3) schedule(static))
   for(int i=mesh->xstart;i<=mesh->xend;i++)
     for(int j=mesh->ystart-1;j<=mesh->yend;j++)
       for(int k=0;k<mesh->LocalNz;k++) {
@@ -96,20 +126,18 @@ const Field3D Div_par_spitzer(BoutReal K0, const Field3D &Te, bool bndry_flux) {
 
         BoutReal gradient = 2.*(Te(i,j+1,k) - Te(i,j,k)) / (coord->dy(i,j) + coord->dy(i,j+1));
 
-        BoutReal flux = K * J * gradient / g_22;
-
-        result(i,j,k) += flux / (coord->dy(i,j) * coord->J(i,j));
-        result(i,j+1,k) -= flux / (coord->dy(i,j+1) * coord->J(i,j+1));
+        flux(i,j,k) = K * J * gradient / g_22;
       }
-  return result;
+  return fluxDivergence(flux, true);
 }
 
 const Field3D Div_par_diffusion_upwind(const Field3D &K, const Field3D &f, bool bndry_flux) {
-  Field3D result;
-  result = 0.0;
+  Field3D flux;
+  flux = 0.0;
   
   Coordinates *coord = mesh->getCoordinates();
 
+  BOUT_OMP(parallel for collapse(3) schedule(static))
   for(int i=mesh->xstart;i<=mesh->xend;i++)
     for(int j=mesh->ystart-1;j<=mesh->yend;j++)
       for(int k=0;k<mesh->LocalNz;k++) {
@@ -135,20 +163,18 @@ const Field3D Div_par_diffusion_upwind(const Field3D &K, const Field3D &f, bool
           c = K(i,j,k);
         }
         
-        BoutReal flux = c * J * gradient / g_22;
-        
-        result(i,j,k) += flux / (coord->dy(i,j) * coord->J(i,j));
-        result(i,j+1,k) -= flux / (coord->dy(i,j+1) * coord->J(i,j+1));
+        flux(i,j,k) = c * J * gradient / g_22;
       }
-  return result;
+  return fluxDivergence(flux, true);
 }
 
 const Field3D Div_par_diffusion_index(const Field3D &f, bool bndry_flux) {
-  Field3D result;
-  result = 0.0;
+  Field3D flux;
+  flux = 0.0;
   
   Coordinates *coord = mesh->getCoordinates();
 
+  BOUT_OMP(parallel for collapse(3) schedule(static))
   for(int i=mesh->xstart;i<=mesh->xend;i++)
     for(int j=mesh->ystart-1;j<=mesh->yend;j++)
       for(int k=0;k<mesh->LocalNz;k++) {
@@ -165,19 +191,17 @@ const Field3D Div_par_diffusion_index(const Field3D &f, bool bndry_flux) {
         
         BoutReal gradient = f(i,j+1,k) - f(i,j,k);
         
-        BoutReal flux = J * gradient;
-        
-        result(i,j,k) += flux / coord->J(i,j);
-        result(i,j+1,k) -= flux / coord->J(i,j+1);
+        flux(i,j,k) = J * gradient;
       }
-  return result;
+  return fluxDivergence(flux, false);
 }
 
 const Field3D AddedDissipation(const Field3D &N, const Field3D &P, const Field3D f, bool bndry_flux) {
-  Field3D result = 0.0;
+  Field3D flux = 0.0;
   
   Coordinates *coord = mesh->getCoordinates();
 
+  BOUT_OMP(parallel for collapse(3) schedule(static))
   for(int i=mesh->xstart;i<=mesh->xend;i++)
     for(int j=mesh->ystart-1;j<=mesh->yend;j++)
       for(int k=0;k<mesh->LocalNz;k++) {
@@ -201,10 +225,8 @@ const Field3D AddedDissipation(const Field3D &N, const Field3D &P, const Field3D
         // Variable being advected. Could use different interpolation?
         BoutReal var = 0.5*(f(i,j,k) + f(i,j+1,k));
 
-        BoutReal flux = var * v * (coord->J(i,j) + coord->J(i,j+1)) / (sqrt(coord->g_22(i,j))+ sqrt(coord->g_22(i,j+1)));
-        
-        result(i,j,k) -= flux / (coord->dy(i,j) * coord->J(i,j));
-        result(i,j+1,k) += flux / (coord->dy(i,j+1) * coord->J(i,j+1));
+        // Flux in the opposite direction to the other operators
+        flux(i,j,k) = - var * v * (coord->J(i,j) + coord->J(i,j+1)) / (sqrt(coord->g_22(i,j))+ sqrt(coord->g_22(i,j+1)));
       }
-  return result;
+  return fluxDivergence(flux, true);
 }
@@ -0,0 +1,101 @@
+#!/usr/bin/env python
+#
+# Grid sequencing for steady-state runs. The case is first converged on a
+# coarse grid, then the solution is remapped onto successively finer grids
+# and converged at each level, ending at the resolution in the input file.
+# Most of the initial transient is then integrated on the cheap coarse
+# grids.
+#
+# Usage: grid-sequence.py --exe path/to/sd1d [--case case-01] [--work sequence]
+#                         [--levels 4] [--factor 2] [--np 1] [--nout 1000]
+#                         [--mpirun mpirun] [option=value ...]
+#
+# Level n runs in <work>/level<n> with mesh:ny = ny / factor**(levels-1-n),
+# stopping when steady (sd1d:stop_on_convergence). Each level after the
+# first starts from the last output of the previous level (sd1d:import_path).
+# The grid must be defined in BOUT.inp in terms of mesh:ny, rather than
+# read from a grid file. Any other option=value arguments are passed to
+# every level.
+
+import argparse
+import os
+import shutil
+import subprocess
+import time
+
+from boutdata import collect
+from boutdata.data import BoutOptionsFile
+
+parser = argparse.ArgumentParser(description="SD1D grid sequencing")
+parser.add_argument("--exe", required=True, help="SD1D executable")
+parser.add_argument("--case", default="case-01", help="Case directory containing BOUT.inp")
+parser.add_argument("--work", default="sequence", help="Directory to run in")
+parser.add_argument("--levels", type=int, default=4, help="Number of grids, including the finest")
+parser.add_argument("--factor", type=int, default=2, help="Refinement between levels")
+parser.add_argument("--np", type=int, default=1, help="Maximum number of MPI ranks")
+parser.add_argument("--nout", type=int, default=1000,
+                    help="Maximum number of outputs at each level")
+parser.add_argument("--mpirun", default="mpirun", help="MPI launcher")
+parser.add_argument("options", nargs="*", help="Options passed to every level")
+args = parser.parse_args()
+
+exe = os.path.abspath(args.exe)
+work = os.path.abspath(args.work)
+
+ny = int(BoutOptionsFile(os.path.join(args.case, "BOUT.inp"))["mesh"]["ny"])
+coarsest = args.factor ** (args.levels - 1)
+if ny % coarsest != 0:
+    raise ValueError("ny = {} is not divisible by {}".format(ny, coarsest))
+
+results = []
+previous = None
+for level in range(args.levels):
+    level_ny = ny // args.factor ** (args.levels - 1 - level)
+    # Largest number of ranks which divides the grid
+    ranks = max(n for n in range(1, args.np + 1) if level_ny % n == 0)
+
+    path = os.path.join(work, "level{}".format(level))
+    if os.path.exists(path):
+        shutil.rmtree(path)
+    shutil.copytree(args.case, path, ignore=shutil.ignore_patterns("*.nc", "BOUT.log.*"))
+
+    command = [args.mpirun, "-np", str(ranks), exe, "-d", path,
+               "nout={}".format(args.nout), "NYPE={}".format(ranks),
+               "mesh:ny={}".format(level_ny), "sd1d:stop_on_convergence=true"]
+    if previous is not None:
+        # Dump files contain the grid spacing, so non-uniform grids are
+        # remapped correctly
+        command += ["sd1d:import_path={}".format(previous),
+                    "sd1d:import_prefix=BOUT.dmp"]
+    command += args.options
+    print(" ".join(command))
+
+    start = time.time()
+    result = subprocess.run(command, cwd=os.path.dirname(exe),
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                            universal_newlines=True)
+    wall_time = time.time() - start
+
+    with open(os.path.join(path, "output.txt"), "w") as f:
+        f.write(result.stdout)
+
+    # A converged run prints "Stopping" then exits with status 0. Older
+    # versions of SD1D stopped through a monitor error, with non-zero
+    # status, so convergence is checked first
+    converged = "Converged for" in result.stdout and "Stopping" in result.stdout
+    if result.returncode != 0 and not converged:
+        raise RuntimeError("Level {} failed with code {}. See {}".format(
+            level, result.returncode, os.path.join(path, "output.txt")))
+    outputs = len(collect("t_array", path=path, info=False)) - 1
+    results.append({"level": level, "ny": level_ny, "ranks": ranks, "outputs": outputs,
+                    "wall_time": wall_time, "converged": converged})
+    if not converged:
+        print("  level {} not converged after {} outputs".format(level, outputs))
+    previous = path
+
+print("\n{:>6s} {:>6s} {:>6s} {:>8s} {:>10s} {:>10s}".format(
+    "level", "ny", "ranks", "outputs", "wall [s]", "converged"))
+for r in results:
+    print("{level:6d} {ny:6d} {ranks:6d} {outputs:8d} {wall_time:10.2f} "
+          "{converged!s:>10s}".format(**r))
+print("Total wall time {:.2f} s".format(sum(r["wall_time"] for r in results)))
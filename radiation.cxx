@@ -12,7 +12,7 @@
 
 using std::string;
 
-const Field3D RadiatedPower::power(const Field3D &Te, const Field3D &Ne, const Field3D &Ni) {
+const Field3D RadiatedPower::power(const Field3D &Te, const Field3D &Ne, const Field3D &Ni) const {
   Field3D result;
   result.allocate();
   
@@ -23,7 +23,53 @@ const Field3D RadiatedPower::power(const Field3D &Te, const Field3D &Ne, const F
   return result;
 }
 
-InterpRadiatedPower::InterpRadiatedPower(const string &filename) {
+namespace {
+/*!
+ * Slopes of a monotone piecewise cubic through (x, y), which doesn't
+ * overshoot the data. Fritsch & Carlson, SIAM J. Numer. Anal. 17 (1980),
+ * with the weighted harmonic mean of Fritsch & Butland for uneven spacing
+ */
+std::vector<BoutReal> pchipSlopes(const std::vector<BoutReal> &x,
+                                  const std::vector<BoutReal> &y) {
+  const int n = x.size();
+  std::vector<BoutReal> h(n - 1), delta(n - 1), m(n);
+  for (int k = 0; k < n - 1; k++) {
+    h[k] = x[k + 1] - x[k];
+    delta[k] = (y[k + 1] - y[k]) / h[k];
+  }
+  if (n == 2) {
+    m[0] = m[1] = delta[0];
+    return m;
+  }
+
+  for (int k = 1; k < n - 1; k++) {
+    if (delta[k - 1] * delta[k] <= 0.0) {
+      m[k] = 0.0; // Local extremum
+    } else {
+      BoutReal w1 = 2. * h[k] + h[k - 1];
+      BoutReal w2 = h[k] + 2. * h[k - 1];
+      m[k] = (w1 + w2) / (w1 / delta[k - 1] + w2 / delta[k]);
+    }
+  }
+
+  // One-sided three-point slopes at the ends, limited to preserve shape
+  auto endSlope = [](BoutReal h0, BoutReal h1, BoutReal d0, BoutReal d1) {
+    BoutReal d = ((2. * h0 + h1) * d0 - h0 * d1) / (h0 + h1);
+    if (d * d0 <= 0.0) {
+      return 0.0;
+    }
+    if ((d0 * d1 <= 0.0) && (fabs(d) > 3. * fabs(d0))) {
+      return 3. * d0;
+    }
+    return d;
+  };
+  m[0] = endSlope(h[0], h[1], delta[0], delta[1]);
+  m[n - 1] = endSlope(h[n - 2], h[n - 3], delta[n - 2], delta[n - 3]);
+  return m;
+}
+} // namespace
+
+InterpRadiatedPower::InterpRadiatedPower(const string &filename, int npoints) {
   std::ifstream file(filename.c_str());
   
   output.write("Loading data from file: %s\n", filename.c_str());
@@ -31,9 +77,14 @@ InterpRadiatedPower::InterpRadiatedPower(const string &filename) {
   if(!file.is_open())
     throw BoutException("InterpRadiatedPower: Couldn't open file %s\n", filename.c_str());
 
+  // Table in log(Te), log(rate)
+  std::vector<BoutReal> logte, logp;
+  
   string line;
-  int linenr = 1;
+  int linenr = 0;
   while( std::getline(file, line) ) {
+    linenr++;
+    
     // Expecting either a comment, blank line, or two numbers
     // Remove comments, then whitespace from left and right
     string strippedline = trim( trimComments( line ) );
@@ -50,50 +101,94 @@ InterpRadiatedPower::InterpRadiatedPower(const string &filename) {
     if( !(ss >> p) )
       throw BoutException("InterpRadiatedPower: file '%s' line %d: %s\n",
                           filename.c_str(), linenr, line.c_str());
+
+    if ((t <= 0.0) || (p <= 0.0))
+      throw BoutException("InterpRadiatedPower: file '%s' line %d: Te and rate "
+                          "must be positive\n", filename.c_str(), linenr);
+    
+    if (!logte.empty() && (log(t) <= logte.back()))
+      throw BoutException("InterpRadiatedPower: file '%s' line %d: Te must be "
+                          "increasing\n", filename.c_str(), linenr);
     
-    te_array.push_back(t);
-    p_array.push_back(p);
+    logte.push_back(log(t));
+    logp.push_back(log(p));
+  }
   
-    linenr++;
+  file.close();
+
+  if (logte.size() < 2)
+    throw BoutException("InterpRadiatedPower: file '%s' has fewer than two points\n",
+                        filename.c_str());
+  if (npoints < 2)
+    throw BoutException("InterpRadiatedPower: npoints must be at least 2\n");
+
+  // Resample onto log-spaced Te
+  std::vector<BoutReal> m = pchipSlopes(logte, logp);
+  
+  const BoutReal dlogte = (logte.back() - logte.front()) / (npoints - 1);
+  std::vector<BoutReal> x(npoints), y(npoints);
+  std::size_t k = 0; // Interval in the file table
+  for (int i = 0; i < npoints; i++) {
+    x[i] = logte.front() + i * dlogte;
+    while ((k < logte.size() - 2) && (x[i] > logte[k + 1]))
+      k++;
+    
+    BoutReal h = logte[k + 1] - logte[k];
+    BoutReal t = (x[i] - logte[k]) / h;
+    // Cubic Hermite basis functions
+    y[i] = (1. + 2. * t) * SQ(1. - t) * logp[k] + t * SQ(1. - t) * h * m[k]
+           + SQ(t) * (3. - 2. * t) * logp[k + 1] + SQ(t) * (t - 1.) * h * m[k + 1];
+  }
+  y.back() = logp.back();
+
+  // Coefficients of the cubic in each interval, in the fractional index
+  m = pchipSlopes(x, y);
+  coefs.resize(npoints - 1);
+  for (int i = 0; i < npoints - 1; i++) {
+    BoutReal m0 = dlogte * m[i], m1 = dlogte * m[i + 1];
+    coefs[i] = {y[i], m0, 3. * (y[i + 1] - y[i]) - 2. * m0 - m1,
+                2. * (y[i] - y[i + 1]) + m0 + m1};
   }
   
+  logte_min = logte.front();
+  inv_dlogte = 1. / dlogte;
+  umax = npoints - 1;
 
-  file.close();
+  output.write("\tCooling curve: %d points, Te from %e to %e eV\n",
+               static_cast<int>(logte.size()), exp(logte.front()), exp(logte.back()));
 }
 
-BoutReal InterpRadiatedPower::power(BoutReal Te, BoutReal ne, BoutReal ni) {
-  return 0.0;
+BoutReal InterpRadiatedPower::power(BoutReal Te, BoutReal ne, BoutReal ni) const {
+  return ne * ni * rate(Te);
 }
 
 ////////////////////////////////////////////////////////////////
 // 
 
-BoutReal HydrogenRadiatedPower::power(BoutReal Te, BoutReal ne, BoutReal ni) {
+BoutReal HydrogenRadiatedPower::power(BoutReal Te, BoutReal ne, BoutReal ni) const {
   
 }
 
 // Collision rate coefficient <sigma*v> [m3/s]
-BoutReal HydrogenRadiatedPower::ionisation(BoutReal T) {
-  double fION;	//collision rate coefficient <sigma*v> [m3/s]
-  double TT,X,S;
+BoutReal HydrogenRadiatedPower::ionisation(BoutReal T) const {
+  return ionisation(LogState(T, 1.0));
+}
 
-  TT=T;
-  
-  if (TT<1.0) TT=1.0;
-  X=log10(TT);
+BoutReal HydrogenRadiatedPower::ionisation(const LogState &s) const {
+  // Te limited to 1 eV
+  const BoutReal X = (s.Te < 1.0) ? 0.0 : s.log10Te;
   
-  if (TT>=20.0) 
-    S=-0.5151*X-2.563/X-5.231;
+  BoutReal S;
+  if (s.Te >= 20.0)
+    S = -0.5151 * X - 2.563 / X - 5.231;
   else
-    S=-3.054*X-15.72*exp(-X)+1.603*exp(-X*X);
-  
-  fION=pow(10.0,S-6.0);           
+    S = -3.054 * X - 15.72 * exp(-X) + 1.603 * exp(-X * X);
   
-  return fION;
+  return pow(10.0, S - 6.0);
 }
 
 //<sigma*v> [m3/s]
-BoutReal HydrogenRadiatedPower::recombination(BoutReal n, BoutReal T) {
+BoutReal HydrogenRadiatedPower::recombination(BoutReal n, BoutReal T) const {
   double fREC;	//<sigma*v> [m3/s]
   double TT,RDNE,RTE,DNE,E,RN,RT,RNJ,RTI,suma;
   int i,j,i1,j1;
@@ -164,7 +259,7 @@ BoutReal HydrogenRadiatedPower::recombination(BoutReal n, BoutReal T) {
 }
 
 // <sigma*v> [m3/s]
-BoutReal HydrogenRadiatedPower::chargeExchange(BoutReal Te) {
+BoutReal HydrogenRadiatedPower::chargeExchange(BoutReal Te) const {
   double fCX;		//<sigma*v> [m3/s]
   double TT,S;
   
@@ -179,7 +274,7 @@ BoutReal HydrogenRadiatedPower::chargeExchange(BoutReal Te) {
 }
 
 // <sigma*v> [m3/s]
-BoutReal HydrogenRadiatedPower::excitation(BoutReal Te) {
+BoutReal HydrogenRadiatedPower::excitation(BoutReal Te) const {
   double fEXC;	//<sigma*v> [m3/s]
   double TT,Y;
   
@@ -197,24 +292,38 @@ BoutReal HydrogenRadiatedPower::excitation(BoutReal Te) {
 /////////////////////////////////////////////////////////////////////////////
 
 
-BoutReal UpdatedRadiatedPower::power(BoutReal Te, BoutReal ne, BoutReal ni) {
+namespace {
+/// Evaluate sum_ij coeffs[j][i] * x^i * y^j in Horner form
+BoutReal polynomial2D(const double coeffs[9][9], BoutReal x, BoutReal y) {
+  BoutReal sum = 0.0;
+  for (int j = 8; j >= 0; j--) {
+    BoutReal row = coeffs[j][8];
+    for (int i = 7; i >= 0; i--) {
+      row = row * x + coeffs[j][i];
+    }
+    sum = sum * y + row;
+  }
+  return sum;
+}
+} // namespace
+
+BoutReal UpdatedRadiatedPower::power(BoutReal Te, BoutReal ne, BoutReal ni) const {
   throw BoutException("UpdatedRadiatedPower::power not implemented");
 }
 
 
 //<sigma*v> [m3/s]
-BoutReal UpdatedRadiatedPower::recombination(BoutReal n, BoutReal T) {
-  double TT, RDNE, RTE, DNE, E, RN, RT, RNJ, RTI, suma, fHAV, fRAD;
-  int i, j, i1, j1;
+BoutReal UpdatedRadiatedPower::recombination(BoutReal n, BoutReal T) const {
+  return recombination(LogState(T, n));
+}
 
-  if (n < 1e3) // Log(n) used, so prevent NaNs
+BoutReal UpdatedRadiatedPower::recombination(const LogState &s) const {
+  if (s.Ne < 1e3) // Log(n) used, so prevent NaNs
     return 0.0;
 
-  if (T < 0.025) {
-    T = 0.025; // 300K
-  }
+  const BoutReal TT = (s.Te < 0.025) ? 0.025 : s.Te; // 300K
 
-  double MATA[9][9] = {
+  static const double MATA[9][9] = {
       {
           -2.855728479302E+01, -7.664042607917E-01, -4.930424003280E-03,
           -5.386830982777E-03, -1.626039237665E-04, 6.080907650243E-06,
@@ -262,52 +371,31 @@ BoutReal UpdatedRadiatedPower::recombination(BoutReal n, BoutReal T) {
       },
   };
 
-  RDNE = n;
-  RTE = T;
-
-  DNE = RDNE;
-  TT = RTE;
-  E = DNE * 1.0E-14;
-
-  RN = log(E);
-  RT = log(TT);
-
-  suma = 0.0;
-  for (i = 1; i <= 9; i++) {
-    i1 = i - 1;
-    for (j = 1; j <= 9; j++) {
-      j1 = j - 1;
-      RNJ = pow(RN, j1);
-      if ((RN == 0.0) && (j1 == 0))
-        RNJ = 1.0;
-      RTI = pow(RT, i1);
-      if ((RT == 0.0) && (i1 == 0))
-        RTI = 1.0;
-      suma = suma + MATA[j - 1][i - 1] * RNJ * RTI;
-    }
-  }
-
-  fHAV = exp(suma) * 1.0E-6 / (1.0 + 0.125 * TT);
+  // Coefficients are MATA[density][temperature]
+  const BoutReal fHAV = exp(polynomial2D(MATA, s.logT, s.logN)) * 1.0E-6 / (1.0 + 0.125 * TT);
 
-  double A = 3.92E-20;
-  double B = 3.0E-124 * pow(1.6E-19, -4.5);
-  double Ry = 13.60569;
-  double chi = 0.35;
+  const double A = 3.92E-20;
+  static const double B = 3.0E-124 * pow(1.6E-19, -4.5);
+  static const double Ry_15 = pow(13.60569, 1.5);
+  const double Ry = 13.60569;
+  const double chi = 0.35;
 
-  fRAD = A * pow(Ry, 1.5) * 1.0 / (sqrt(TT) * (Ry + chi * TT));
+  const BoutReal fRAD = A * Ry_15 / (sqrt(TT) * (Ry + chi * TT));
 
-  return fHAV + fRAD + B * DNE * pow(TT, -5.0);
+  const BoutReal TT2 = TT * TT;
+  return fHAV + fRAD + B * s.Ne / (TT2 * TT2 * TT);
 }
 
 // <sigma*v> [m3/s]
-BoutReal UpdatedRadiatedPower::chargeExchange(BoutReal T) {
-  if (T < 0.025) {
-    T = 0.025; // 300K
-  }
+BoutReal UpdatedRadiatedPower::chargeExchange(BoutReal T) const {
+  return chargeExchange(LogState(T, 1.0));
+}
 
-  double E = 10.0;
+BoutReal UpdatedRadiatedPower::chargeExchange(const LogState &s) const {
+  // Energy is fixed at 10 eV
+  const double E = 10.0;
 
-  double cxcoeffs[9][9] = {
+  static const double cxcoeffs[9][9] = {
       {
           -1.829079582E1, 1.640252721E-1, 3.364564509E-2, 9.530225559E-3,
           -8.519413900E-4, -1.247583861E-3, 3.014307546E-4, -2.499323170E-5,
@@ -355,18 +443,28 @@ BoutReal UpdatedRadiatedPower::chargeExchange(BoutReal T) {
       },
   };
 
-  double lograte = 0.0;
-  for (int i = 0; i <= 8; i++) {
-    for (int j = 0; j <= 8; j++) {
-      lograte = lograte + cxcoeffs[i][j] * pow(log(T), i) * pow(log(E), j);
+  // Sum over energy once, leaving a polynomial in log(T)
+  static const std::array<double, 9> coeffs = [&] {
+    std::array<double, 9> result;
+    for (int i = 0; i <= 8; i++) {
+      result[i] = 0.0;
+      for (int j = 8; j >= 0; j--) {
+        result[i] = result[i] * log(E) + cxcoeffs[i][j];
+      }
     }
+    return result;
+  }();
+
+  double lograte = 0.0;
+  for (int i = 8; i >= 0; i--) {
+    lograte = lograte * s.logT + coeffs[i];
   }
 
   return 1.0E-6 * exp(lograte);
 }
 
 // Original excitation rate
-BoutReal UpdatedRadiatedPower::excitation_old(BoutReal Te) {
+BoutReal UpdatedRadiatedPower::excitation_old(BoutReal Te) const {
   double fEXC;	//<sigma*v> [m3/s]
   double TT,Y;
   
@@ -382,48 +480,34 @@ BoutReal UpdatedRadiatedPower::excitation_old(BoutReal Te) {
 
 // Original ionisation rate
 // Collision rate coefficient <sigma*v> [m3/s]
-BoutReal UpdatedRadiatedPower::ionisation_old(BoutReal T) {
-    double fION; // Rate coefficient
-    double TT;
-
-    if (T < 0.025) {
-      T = 0.025; // 300K
-    }
-    
-    TT = T;
+BoutReal UpdatedRadiatedPower::ionisation_old(BoutReal T) const {
+  return ionisation_old(LogState(T, 1.0));
+}
 
-    double ioncoeffs[9] = {-3.271397E1, 1.353656E1, -5.739329, 1.563155, \
+BoutReal UpdatedRadiatedPower::ionisation_old(const LogState &s) const {
+    static const double ioncoeffs[9] = {-3.271397E1, 1.353656E1, -5.739329, 1.563155, \
 			   -2.877056E-1, 3.482560e-2, -2.631976E-3, \
 			   1.119544E-4, -2.039150E-6};
     
     double lograte = 0.0;
-    for (int i=0;i<=8;i++)
-      {
-	lograte = lograte + ioncoeffs[i]*pow(log(TT),i);
-      }
-
-    fION = exp(lograte)*1.0E-6;
+    for (int i = 8; i >= 0; i--) {
+      lograte = lograte * s.logT + ioncoeffs[i];
+    }
 
-    return fION;
+    return exp(lograte)*1.0E-6;
 }
 
 // <sigma*v> [m3/s]
 // COMES FROM AMJUEL H.4 2.1.5 (SAWADA)
-BoutReal UpdatedRadiatedPower::ionisation(BoutReal n, BoutReal T) {
-  // double TT, RDNE, RTE, DNE, E, RN, RT, RNJ, RTI, suma, fION;
-  // int i, j, i1, j1;
-  
-  double E, suma, fION;
-  int i, j;
+BoutReal UpdatedRadiatedPower::ionisation(BoutReal n, BoutReal T) const {
+  return ionisation(LogState(T, n));
+}
 
-  if (n < 1e3) // Log(n) used, so prevent NaNs
+BoutReal UpdatedRadiatedPower::ionisation(const LogState &s) const {
+  if (s.Ne < 1e3) // Log(n) used, so prevent NaNs
     return 0.0;
 
-  if (T < 0.025) {
-    T = 0.025; // 300K
-  }
-
-  double MATA[9][9] = {
+  static const double MATA[9][9] = {
       {
           -3.248025330340E+01, 1.425332391510E+01, -6.632235026785E+00,
           2.059544135448E+00, -4.425370331410E-01, 6.309381861496E-02,
@@ -471,64 +555,23 @@ BoutReal UpdatedRadiatedPower::ionisation(BoutReal n, BoutReal T) {
       },
   };
 
-  // RDNE = n;
-  // RTE = T;
-
-  // DNE = RDNE;
-  // TT = RTE;
-  // E = DNE * 1.0E-14;
-
-  // RN = log(E);
-  // RT = log(TT);
-
-  // suma = 0.0;
-  // for (i = 1; i <= 9; i++) {
-    // i1 = i - 1;
-    // for (j = 1; j <= 9; j++) {
-      // j1 = j - 1;
-      // RNJ = pow(RN, j1);
-      // if ((RN == 0.0) && (j1 == 0))
-        // RNJ = 1.0;
-      // RTI = pow(RT, i1);
-      // if ((RT == 0.0) && (i1 == 0))
-        // RTI = 1.0;
-      // suma = suma + MATA[j - 1][i - 1] * RNJ * RTI;
-    // }
-  // }
-  
-  E = n * 1.0E-14;
-  E = log(E);
-  T = log(T);
-  
-  suma = 0.0;
-  
-  for (i = 0; i <=8; i++) {
-	  for (j = 0; j <= 8; j++) {
-		  suma = suma + MATA[j][i] * pow(E,j) * pow(T,i);
-	  }
-  }
-
-  fION = exp(suma)*1.0E-6;
-
-  return fION;
+  // Coefficients are MATA[density][temperature]
+  return exp(polynomial2D(MATA, s.logT, s.logN)) * 1.0E-6;
 }
 
 // COMES FROM AMJUEL H.10 2.1.5 (SAWADA)
 // This is an energy weighted rate (m-3s-1eV) for energy loss due to multistep ionisation in a 9 coefficient 2D polynomial fit
 // It includes energy loss due to ionisation (i.e. 13.6eV) within it, so for SD1D's definition we need to separate this out later
 // this is done in sd1d.cxx
-BoutReal UpdatedRadiatedPower::excitation(BoutReal n, BoutReal T) {
-  double E, suma, fEXC;
-  int i, j;
+BoutReal UpdatedRadiatedPower::excitation(BoutReal n, BoutReal T) const {
+  return excitation(LogState(T, n));
+}
 
-  if (n < 1e3) // Log(n) used, so prevent NaNs
+BoutReal UpdatedRadiatedPower::excitation(const LogState &s) const {
+  if (s.Ne < 1e3) // Log(n) used, so prevent NaNs
     return 0.0;
 
-  if (T < 0.025) {
-    T = 0.025; // 300K
-  }
-
-  double MATA[9][9] = {
+  static const double MATA[9][9] = {
       {
           -2.497580168306E+01, 1.004448839974E+01, -4.867952931298E+00,
           1.689422238067E+00, -4.103532320100E-01, 6.469718387357E-02,
@@ -576,47 +619,8 @@ BoutReal UpdatedRadiatedPower::excitation(BoutReal n, BoutReal T) {
       },
   };
 
-  // RDNE = n;
-  // RTE = T;
-
-  // DNE = RDNE;
-  // TT = RTE;
-  // E = DNE * 1.0E-14;
-
-  // RN = log(E);
-  // RT = log(TT);
-
-  // suma = 0.0;
-  // for (i = 1; i <= 9; i++) {
-    // i1 = i - 1;
-    // for (j = 1; j <= 9; j++) {
-      // j1 = j - 1;
-      // RNJ = pow(RN, j1);
-      // if ((RN == 0.0) && (j1 == 0))
-        // RNJ = 1.0;
-      // RTI = pow(RT, i1);
-      // if ((RT == 0.0) && (i1 == 0))
-        // RTI = 1.0;
-      // suma = suma + MATA[j - 1][i - 1] * RNJ * RTI;
-    // }
-  // }
-
-  // fEXC = exp(suma)*1.0E-6;
-  
-  E = n * 1.0E-14;
-  E = log(E);
-  T = log(T);
-  
-  suma = 0.0;
-  
-  for (i = 0; i <=8; i++) {
-	  for (j = 0; j <= 8; j++) {
-		  suma = suma + MATA[j][i] * pow(E,j) * pow(T,i);
-	  }
-  }
-
-  fEXC = exp(suma)*1.0E-6;
-  return fEXC;
+  // Coefficients are MATA[density][temperature]
+  return exp(polynomial2D(MATA, s.logT, s.logN)) * 1.0E-6;
 }
 
 // The below comes from the work of Yulin Zhou
@@ -625,282 +629,244 @@ BoutReal UpdatedRadiatedPower::excitation(BoutReal n, BoutReal T) {
 /////////////////////   Excitation ////////////////////
 ///Channel H////////
 
-BoutReal UpdatedRadiatedPower::Channel_H_2_amjuel(BoutReal T,BoutReal Ne) {
-  if (T < 0.025) {
-    T = 0.025; // 300K
-  }
-  double Channel_H_RateCoefficient_2,rate_Channel_H,TT,NN;
-  TT = T;
-  NN=Ne*1.0e-14;
-
-  double Channel_H_coeffs_2[9][9]= {{-2.888782240542E+01, 9.694042304562E-01, 4.613129045722E-02,
-                               -2.216757216719E-02, 5.067711671376E-03, -6.212032986616E-04,
-                               4.172445968364E-05, -1.439572350231E-06, 1.978486731178E-08,},
-                              {9.909537514500E+00, -4.163537878599E-02, 2.444011013342E-02,
-                               -5.092551836572E-03, 4.080645015829E-04, -5.739581031596E-06,
-                               -6.441112682031E-07, 1.766524953307E-08, 4.500335193180E-11,},
-                              {-4.942743781185E+00, 1.230545313063E-02, -1.289174377763E-02,
-                               4.174980751883E-03, -5.559754475561E-04, 2.207616832672E-05,
-                               1.604359947467E-06, -1.668549821257E-07, 3.956288361818E-09,},
-                              {1.715668267417E+00, 3.034149311755E-02, -1.837812030403E-02,
-                               3.719122644080E-03, -2.039974521144E-04, -2.170634046629E-05,
-                               3.319046346231E-06, -1.530562339677E-07, 2.467744887550E-09,},
-                              {-4.508004155190E-01, -1.136449435241E-02, 7.857406065923E-03,
-                               -1.818309410916E-03, 1.348196284756E-04, 7.621772971297E-06,
-                               -1.742105663717E-06, 9.539025646066E-08, -1.764749848063E-09,},
-                              {9.042516000563E-02, -2.874540451423E-03, 1.787805444265E-03,
-                               -4.049163510078E-04, 3.839701084642E-05, -1.182790529172E-06,
-                               -3.224230256996E-08, 2.293257666191E-09, -2.626033062059E-11,},
-                              {-1.280973933282E-02, 1.947546784046E-03, -1.325209820376E-03,
-                               3.200749637228E-04, -3.075854301471E-05, 4.485031199179E-07,
-                               1.187820950781E-07, -7.725204735890E-09, 1.455730327605E-10,},
-                              {1.084341450206E-03, -3.175349945580E-04, 2.227323600480E-04,
-                               -5.559573928329E-05, 5.656373947352E-06, -1.236115053324E-07,
-                               -1.829679294498E-08, 1.312011360384E-09, -2.576831583186E-11,},
-                              {-3.974359134401E-05, 1.688199339120E-05, -1.209472946500E-05,
-                               3.100021285561E-06, -3.323560174565E-07, 9.896407186442E-09,
-                               8.003219743811E-10, -6.578827971726E-11, 1.343525928267E-12,}
-                             };
-
-  Channel_H_RateCoefficient_2=0;
-
-if (NN<=1.0) {
-     for (int i = 0;i <= 8;i++) {
-          Channel_H_RateCoefficient_2 += Channel_H_coeffs_2[i][0]*pow(log(TT),i);
-     }
-     rate_Channel_H = exp(Channel_H_RateCoefficient_2);
-
-}else{
-     for (int i=0;i<=8;i++){
-         for (int j=0;j<=8;j++){
-             Channel_H_RateCoefficient_2 += Channel_H_coeffs_2[i][j]*pow(log(TT),i)*pow(log(NN),j);
-         }
-     }
-     rate_Channel_H = exp(Channel_H_RateCoefficient_2);
-}
-return rate_Channel_H;
-}
-
-///////////channel H(3)//////////////
-BoutReal UpdatedRadiatedPower::Channel_H_3_amjuel(BoutReal T,BoutReal Ne) {
-  if (T < 0.025) {
-    T = 0.025; // 300K
-  }
-  double Channel_H_RateCoefficient_3,rate_Channel_H,TT,NN;
-  TT = T;
-  NN=Ne*1.0e-14;
-
-  double Channel_H_coeffs_3[9][9]= {{-3.082877684472E+01, 9.740982428834E-01, 2.693447564427E-02,
-                               -9.004934091051E-03, 1.222843687947E-03, -5.210804049741E-05,
-                               -2.739765256223E-06, 2.927097984040E-07, -6.646459819509E-09,},
-                              {1.187030265272E+01, 1.968338090648E-02, -2.495504765088E-02,
-                               1.123130855030E-02, -2.651909936461E-03, 3.534709147248E-04,
-                               -2.632450715422E-05, 9.987762315441E-07, -1.501421276021E-08,},
-                              {-5.889482037865E+00, -8.737684945730E-03, 9.951688266911E-03,
-                               -5.241271640755E-03, 1.372483328336E-03, -1.917275090304E-04,
-                               1.441627470961E-05, -5.481720522735E-07, 8.264009775214E-09,},
-                              {2.017399399792E+00, -1.014609925009E-02, 1.040081859210E-02,
-                               -3.478025606446E-03, 5.572774095384E-04, -4.848784231802E-05,
-                               2.416915703008E-06, -6.658457254421E-08, 8.215818515744E-10,},
-                              {-5.303360302839E-01, 3.297808176838E-03, -2.712205422397E-03,
-                               8.454526208306E-04, -1.362168127545E-04, 1.306146151315E-05,
-                               -7.772290534634E-07, 2.655224800515E-08, -3.968977724198E-10,},
-                              {1.080451047951E-01, 9.673290806118E-04, -1.096708705743E-03,
-                               3.872258199271E-04, -6.353971343367E-05, 5.417022322731E-06,
-                               -2.470245979511E-07, 5.722044899754E-09, -5.443566855045E-11,},
-                              {-1.555010466762E-02, -5.167168286670E-04, 4.637911190482E-04,
-                               -1.380893374707E-04, 1.849429028886E-05, -1.166761555949E-06,
-                               2.955124264492E-08, 3.184408123607E-11, -8.216232831023E-12,},
-                              {1.327158680898E-03, 7.389473703435E-05, -5.797555862425E-05,
-                               1.440341699187E-05, -1.290902554237E-06, -4.889963932464E-09,
-                               7.390396686250E-09, -4.052521721349E-10, 6.720841155202E-12,},
-                              {-4.872105203992E-05, -3.537584073064E-06, 2.453443334473E-06,
-                               -4.745956710582E-07, 5.546604517157E-09, 7.579547673173E-09,
-                               -8.635578634097E-10, 3.738695038824E-11, -5.757075610089E-13,},
-                             };
-
-  Channel_H_RateCoefficient_3=0;
-
-if (NN<=1.0) {
-     for (int i = 0;i <= 8;i++) {
-          Channel_H_RateCoefficient_3 += Channel_H_coeffs_3[i][0]*pow(log(TT),i);
-     }
-     rate_Channel_H = exp(Channel_H_RateCoefficient_3);
-
-}else{
-     for (int i=0;i<=8;i++){
-         for (int j=0;j<=8;j++){
-             Channel_H_RateCoefficient_3 += Channel_H_coeffs_3[i][j]*pow(log(TT),i)*pow(log(NN),j);
-         }
-     }
-     rate_Channel_H = exp(Channel_H_RateCoefficient_3);
-}
-return rate_Channel_H;
-}
-
-
-///////////channel H(4)//////////////
-BoutReal UpdatedRadiatedPower::Channel_H_4_amjuel(BoutReal T,BoutReal Ne) {
-  if (T < 0.025) {
-    T = 0.025; // 300K
+namespace {
+/// AMJUEL H.12 2.1.5b - 2.1.5e fits for the population of excited states
+/// n = 2 to 6, relative to the ground state. The fit is
+///   log(Nn(n) / Nn(1)) = sum_ij coeffs[i][j] log(T)^i log(Ne * 1e-14)^j
+/// with T in eV and Ne in m^-3
+const double channel_h_coeffs[5][9][9] = {
+    // n = 2
+    {
+        {-2.888782240542E+01, 9.694042304562E-01, 4.613129045722E-02,
+         -2.216757216719E-02, 5.067711671376E-03, -6.212032986616E-04,
+         4.172445968364E-05, -1.439572350231E-06, 1.978486731178E-08},
+        {9.909537514500E+00, -4.163537878599E-02, 2.444011013342E-02,
+         -5.092551836572E-03, 4.080645015829E-04, -5.739581031596E-06,
+         -6.441112682031E-07, 1.766524953307E-08, 4.500335193180E-11},
+        {-4.942743781185E+00, 1.230545313063E-02, -1.289174377763E-02,
+         4.174980751883E-03, -5.559754475561E-04, 2.207616832672E-05,
+         1.604359947467E-06, -1.668549821257E-07, 3.956288361818E-09},
+        {1.715668267417E+00, 3.034149311755E-02, -1.837812030403E-02,
+         3.719122644080E-03, -2.039974521144E-04, -2.170634046629E-05,
+         3.319046346231E-06, -1.530562339677E-07, 2.467744887550E-09},
+        {-4.508004155190E-01, -1.136449435241E-02, 7.857406065923E-03,
+         -1.818309410916E-03, 1.348196284756E-04, 7.621772971297E-06,
+         -1.742105663717E-06, 9.539025646066E-08, -1.764749848063E-09},
+        {9.042516000563E-02, -2.874540451423E-03, 1.787805444265E-03,
+         -4.049163510078E-04, 3.839701084642E-05, -1.182790529172E-06,
+         -3.224230256996E-08, 2.293257666191E-09, -2.626033062059E-11},
+        {-1.280973933282E-02, 1.947546784046E-03, -1.325209820376E-03,
+         3.200749637228E-04, -3.075854301471E-05, 4.485031199179E-07,
+         1.187820950781E-07, -7.725204735890E-09, 1.455730327605E-10},
+        {1.084341450206E-03, -3.175349945580E-04, 2.227323600480E-04,
+         -5.559573928329E-05, 5.656373947352E-06, -1.236115053324E-07,
+         -1.829679294498E-08, 1.312011360384E-09, -2.576831583186E-11},
+        {-3.974359134401E-05, 1.688199339120E-05, -1.209472946500E-05,
+         3.100021285561E-06, -3.323560174565E-07, 9.896407186442E-09,
+         8.003219743811E-10, -6.578827971726E-11, 1.343525928267E-12},
+    },
+    // n = 3
+    {
+        {-3.082877684472E+01, 9.740982428834E-01, 2.693447564427E-02,
+         -9.004934091051E-03, 1.222843687947E-03, -5.210804049741E-05,
+         -2.739765256223E-06, 2.927097984040E-07, -6.646459819509E-09},
+        {1.187030265272E+01, 1.968338090648E-02, -2.495504765088E-02,
+         1.123130855030E-02, -2.651909936461E-03, 3.534709147248E-04,
+         -2.632450715422E-05, 9.987762315441E-07, -1.501421276021E-08},
+        {-5.889482037865E+00, -8.737684945730E-03, 9.951688266911E-03,
+         -5.241271640755E-03, 1.372483328336E-03, -1.917275090304E-04,
+         1.441627470961E-05, -5.481720522735E-07, 8.264009775214E-09},
+        {2.017399399792E+00, -1.014609925009E-02, 1.040081859210E-02,
+         -3.478025606446E-03, 5.572774095384E-04, -4.848784231802E-05,
+         2.416915703008E-06, -6.658457254421E-08, 8.215818515744E-10},
+        {-5.303360302839E-01, 3.297808176838E-03, -2.712205422397E-03,
+         8.454526208306E-04, -1.362168127545E-04, 1.306146151315E-05,
+         -7.772290534634E-07, 2.655224800515E-08, -3.968977724198E-10},
+        {1.080451047951E-01, 9.673290806118E-04, -1.096708705743E-03,
+         3.872258199271E-04, -6.353971343367E-05, 5.417022322731E-06,
+         -2.470245979511E-07, 5.722044899754E-09, -5.443566855045E-11},
+        {-1.555010466762E-02, -5.167168286670E-04, 4.637911190482E-04,
+         -1.380893374707E-04, 1.849429028886E-05, -1.166761555949E-06,
+         2.955124264492E-08, 3.184408123607E-11, -8.216232831023E-12},
+        {1.327158680898E-03, 7.389473703435E-05, -5.797555862425E-05,
+         1.440341699187E-05, -1.290902554237E-06, -4.889963932464E-09,
+         7.390396686250E-09, -4.052521721349E-10, 6.720841155202E-12},
+        {-4.872105203992E-05, -3.537584073064E-06, 2.453443334473E-06,
+         -4.745956710582E-07, 5.546604517157E-09, 7.579547673173E-09,
+         -8.635578634097E-10, 3.738695038824E-11, -5.757075610089E-13},
+    },
+    // n = 4
+    {
+        {-3.121459339796E+01, 8.335828009713E-01, 2.325042085123E-01,
+         -1.096388203376E-01, 2.434624647621E-02, -2.848412091044E-03,
+         1.789669578362E-04, -5.712451213773E-06, 7.267386885023E-08},
+        {1.250950592132E+01, 9.112878380113E-03, -5.491646502669E-02,
+         2.972045500915E-02, -6.752777629102E-03, 7.907482466413E-04,
+         -5.078726612521E-05, 1.694110618282E-06, -2.296731891384E-08},
+        {-6.229984587067E+00, -1.938627422961E-02, 1.621303063286E-02,
+         -6.819605362801E-03, 1.639046907231E-03, -2.316409264833E-04,
+         1.859544292047E-05, -7.663932535000E-07, 1.248233937322E-08},
+        {2.142105600364E+00, 3.084489232048E-02, -3.147946146487E-03,
+         -4.981563534979E-03, 1.797076203455E-03, -2.547644660956E-04,
+         1.790413918002E-05, -6.225635876900E-07, 8.589352663796E-09},
+        {-5.615155300856E-01, -5.885518785970E-03, -1.131771898094E-03,
+         2.277414510956E-03, -7.295707497520E-04, 1.047093315160E-04,
+         -7.734966472367E-06, 2.868598630187E-07, -4.235795995646E-09},
+        {1.127449459065E-01, -6.211271050025E-03, 3.856805502108E-03,
+         -9.720154554360E-04, 1.201895430371E-04, -7.956678504065E-06,
+         2.942004754571E-07, -6.030861909870E-09, 5.715848860621E-11},
+        {-1.590343046823E-02, 2.950230045038E-03, -1.748272049931E-03,
+         3.838584264558E-04, -3.212460389716E-05, -8.181068284295E-08,
+         1.721805311242E-07, -9.730371684031E-09, 1.730299677672E-10},
+        {1.333705010633E-03, -4.583201098446E-04, 2.858630200307E-04,
+         -6.739012881651E-05, 6.684315041032E-06, -1.703080933280E-07,
+         -1.655594650506E-08, 1.235894145239E-09, -2.408500349383E-11},
+        {-4.836027605927E-05, 2.417569815070E-05, -1.585276481393E-05,
+         4.013119711268E-06, -4.619672863742E-07, 2.215787076654E-08,
+         2.731478375019E-11, -3.750344543532E-11, 9.061707694269E-13},
+    },
+    // n = 5
+    {
+        {-3.126718125624E+01, 9.282945460974E-01, 1.070213380676E-01,
+         -5.984835557747E-02, 1.574482420977E-02, -2.152803383431E-03,
+         1.533450613139E-04, -5.416190220272E-06, 7.503092506245E-08},
+        {1.281374709913E+01, 3.573873112144E-02, -4.872701879146E-02,
+         2.122340688681E-02, -4.335261058803E-03, 4.511000731668E-04,
+         -2.514757812007E-05, 7.098607959133E-07, -7.948198678409E-09},
+        {-6.380408105491E+00, -1.144110981890E-03, -4.680598150266E-05,
+         4.899399906199E-04, -1.730051136321E-04, 2.045111743029E-05,
+         -4.780097207035E-07, -3.664829135622E-08, 1.435704784493E-09},
+        {2.191577061685E+00, -5.161589020256E-03, 6.439656957369E-03,
+         -2.595193985854E-03, 5.083896758770E-04, -5.001475048416E-05,
+         2.378856833473E-06, -4.662729327187E-08, 1.885707833825E-10},
+        {-5.751755938054E-01, 1.676622419964E-03, -1.568501026478E-03,
+         5.235042780927E-04, -8.901350181088E-05, 8.437562876296E-06,
+         -4.722754735716E-07, 1.525662957088E-08, -2.277373255316E-10},
+        {1.157406495600E-01, 1.486290009897E-04, -1.404765081110E-04,
+         1.953433357615E-05, 3.171136646292E-06, -1.281135706652E-06,
+         1.539182389681E-07, -7.795475709363E-09, 1.408203935795E-10},
+        {-1.631671197369E-02, -2.016003370833E-04, 1.639222741263E-04,
+         -3.782479181914E-05, 2.829273502486E-06, 1.645529677700E-07,
+         -3.844013350899E-08, 2.070018927471E-09, -3.568996816514E-11},
+        {1.362647208936E-03, 3.901702147732E-05, -3.141140575728E-05,
+         7.810730453019E-06, -7.640509497691E-07, 9.357372398314E-09,
+         3.398945819263E-09, -2.120439941817E-10, 3.643140818164E-12},
+        {-4.908854946631E-05, -2.325049769834E-06, 1.888930116590E-06,
+         -4.970298877362E-07, 5.607762235203E-08, -2.232480288100E-09,
+         -6.095037813579E-11, 6.718495301125E-12, -1.229967242093E-13},
+    },
+    // n = 6
+    {
+        {-3.118788806329E+01, 1.051705868661E+00, -6.954764617920E-02,
+         2.612329534702E-02, -3.911384137475E-03, 1.474794675693E-04,
+         9.191757017392E-06, -7.898231632650E-07, 1.514512376570E-08},
+        {1.300365034969E+01, 5.806024278787E-02, -7.054107872877E-02,
+         3.209814487839E-02, -7.336538391803E-03, 8.838327301328E-04,
+         -5.779085565904E-05, 1.935287412436E-06, -2.603161887414E-08},
+        {-6.464611656902E+00, -3.350148712230E-02, 3.809632279775E-02,
+         -1.663574690203E-02, 3.667522832624E-03, -4.409479869479E-04,
+         2.975048782418E-05, -1.054940416948E-06, 1.523660684271E-08},
+        {2.198690942590E+00, -1.651116960139E-02, 1.248202030331E-02,
+         -3.600008781362E-03, 5.273464947078E-04, -4.137511227236E-05,
+         1.553774051571E-06, -1.704433673171E-08, -2.016881015852E-10},
+        {-5.762198964354E-01, 8.782966049217E-03, -7.253814512300E-03,
+         2.434417487959E-03, -4.385057360151E-04, 4.589037396076E-05,
+         -2.785668187173E-06, 9.065547432614E-08, -1.223436753078E-09},
+        {1.190459835777E-01, 7.937734220940E-04, -3.032198147605E-04,
+         -6.693627833492E-05, 4.755833322780E-05, -8.654363224389E-06,
+         7.303664535216E-07, -2.952279140710E-08, 4.597194098628E-10},
+        {-1.758172528529E-02, -8.425168421647E-04, 4.935184501531E-04,
+         -8.020637279277E-05, -2.254322145665E-06, 1.858918078917E-06,
+         -1.970736415814E-07, 8.619751903229E-09, -1.383868509607E-10},
+        {1.540671110406E-03, 1.322737632505E-04, -7.161027491097E-05,
+         9.120131097155E-06, 1.138969748088E-06, -3.791832116704E-07,
+         3.596045684588E-08, -1.495930494169E-09, 2.332244458469E-11},
+        {-5.782468318198E-05, -6.483373521666E-06, 3.088146690349E-06,
+         -1.704370060355E-07, -1.258928004543E-07, 2.744344149529E-08,
+         -2.357827363714E-09, 9.371149524100E-11, -1.424213663602E-12},
+    },
+};
+
+/// Energy gap between levels n and 1 [eV], for n = 2 to 6
+const BoutReal excited_energy[5] = {10.2, 12.1, 12.8, 13.05, 13.22};
+
+/// Einstein coefficients for n -> 1 [s^-1], for n = 2 to 6
+/// http://astronomy.nmsu.edu/cwc/CWC/545/13-AtomsHydrogenic.pdf
+/// NOTE THAT A21 IS FROM YULIN'S SD1D CODE BUT SEEMS NOT CORRECT
+const BoutReal einstein_A[5] = {1.6986e+09, 5.5751e7, 1.2785e7, 4.1250e6, 1.6440e6};
+
+/// Powers 0 to 8 of log(T) and log(Ne * 1e-14), shared by all channels.
+/// T is limited to 0.025 eV (300K). At or below Ne = 1e14 m^-3 only
+/// the j = 0 coefficients are used
+struct ChannelPowers {
+  explicit ChannelPowers(const LogState &s) {
+    const BoutReal logT = s.logT;
+    const BoutReal logN = (s.logN <= 0.0) ? 0.0 : s.logN;
+    t[0] = n[0] = 1.0;
+    for (int i = 1; i < 9; i++) {
+      t[i] = t[i - 1] * logT;
+      n[i] = n[i - 1] * logN; // Zero if NN <= 1
+    }
   }
-  double Channel_H_RateCoefficient_4,rate_Channel_H,TT,NN;
-  TT = T;
-  NN=Ne*1.0e-14;
-
-  double Channel_H_coeffs_4[9][9]= {{-3.121459339796E+01, 8.335828009713E-01, 2.325042085123E-01,
-                               -1.096388203376E-01, 2.434624647621E-02, -2.848412091044E-03,
-                               1.789669578362E-04, -5.712451213773E-06, 7.267386885023E-08,},
-                              {1.250950592132E+01, 9.112878380113E-03, -5.491646502669E-02,
-                               2.972045500915E-02, -6.752777629102E-03, 7.907482466413E-04,
-                               -5.078726612521E-05, 1.694110618282E-06, -2.296731891384E-08,},
-                              {-6.229984587067E+00, -1.938627422961E-02, 1.621303063286E-02,
-                               -6.819605362801E-03, 1.639046907231E-03, -2.316409264833E-04,
-                               1.859544292047E-05, -7.663932535000E-07, 1.248233937322E-08,},
-                              {2.142105600364E+00, 3.084489232048E-02, -3.147946146487E-03,
-                               -4.981563534979E-03, 1.797076203455E-03, -2.547644660956E-04,
-                               1.790413918002E-05, -6.225635876900E-07, 8.589352663796E-09,},
-                              {-5.615155300856E-01, -5.885518785970E-03, -1.131771898094E-03,
-                               2.277414510956E-03, -7.295707497520E-04, 1.047093315160E-04,
-                               -7.734966472367E-06, 2.868598630187E-07, -4.235795995646E-09,},
-                              {1.127449459065E-01, -6.211271050025E-03, 3.856805502108E-03,
-                               -9.720154554360E-04, 1.201895430371E-04, -7.956678504065E-06,
-                               2.942004754571E-07, -6.030861909870E-09, 5.715848860621E-11,},
-                              {-1.590343046823E-02, 2.950230045038E-03, -1.748272049931E-03,
-                               3.838584264558E-04, -3.212460389716E-05, -8.181068284295E-08,
-                               1.721805311242E-07, -9.730371684031E-09, 1.730299677672E-10,},
-                              {1.333705010633E-03, -4.583201098446E-04, 2.858630200307E-04,
-                               -6.739012881651E-05, 6.684315041032E-06, -1.703080933280E-07,
-                               -1.655594650506E-08, 1.235894145239E-09, -2.408500349383E-11,},
-                              {-4.836027605927E-05, 2.417569815070E-05, -1.585276481393E-05,
-                               4.013119711268E-06, -4.619672863742E-07, 2.215787076654E-08,
-                               2.731478375019E-11, -3.750344543532E-11, 9.061707694269E-13,},};
-  Channel_H_RateCoefficient_4=0;
-
-if (NN<=1.0) {
-     for (int i = 0;i <= 8;i++) {
-          Channel_H_RateCoefficient_4 += Channel_H_coeffs_4[i][0]*pow(log(TT),i);
-     }
-     rate_Channel_H = exp(Channel_H_RateCoefficient_4);
-
-}else{
-     for (int i=0;i<=8;i++){
-         for (int j=0;j<=8;j++){
-             Channel_H_RateCoefficient_4 += Channel_H_coeffs_4[i][j]*pow(log(TT),i)*pow(log(NN),j);
-         }
-     }
-     rate_Channel_H = exp(Channel_H_RateCoefficient_4);
-}
-return rate_Channel_H;
-}
-
-///////////channel H(5)//////////////
-BoutReal UpdatedRadiatedPower::Channel_H_5_amjuel(BoutReal T,BoutReal Ne) {
-  if (T < 0.025) {
-    T = 0.025; // 300K
+  BoutReal t[9], n[9];
+};
+
+/// Population of one excited state relative to the ground state
+BoutReal channelH(const double coeffs[9][9], const ChannelPowers &p) {
+  BoutReal sum = 0.0;
+  for (int i = 0; i < 9; i++) {
+    BoutReal row = 0.0;
+    for (int j = 0; j < 9; j++) {
+      row += coeffs[i][j] * p.n[j];
+    }
+    sum += row * p.t[i];
   }
-  double Channel_H_RateCoefficient_5,rate_Channel_H,TT,NN;
-  TT = T;
-  NN=Ne*1.0e-14;
-
-  double Channel_H_coeffs_5[9][9]= {{-3.126718125624E+01, 9.282945460974E-01, 1.070213380676E-01,
-                               -5.984835557747E-02, 1.574482420977E-02, -2.152803383431E-03,
-                               1.533450613139E-04, -5.416190220272E-06, 7.503092506245E-08,},
-                              {1.281374709913E+01, 3.573873112144E-02, -4.872701879146E-02,
-                               2.122340688681E-02, -4.335261058803E-03, 4.511000731668E-04,
-                               -2.514757812007E-05, 7.098607959133E-07, -7.948198678409E-09,},
-                              {-6.380408105491E+00, -1.144110981890E-03, -4.680598150266E-05,
-                               4.899399906199E-04, -1.730051136321E-04, 2.045111743029E-05,
-                               -4.780097207035E-07, -3.664829135622E-08, 1.435704784493E-09,},
-                              {2.191577061685E+00, -5.161589020256E-03, 6.439656957369E-03,
-                               -2.595193985854E-03, 5.083896758770E-04, -5.001475048416E-05,
-                               2.378856833473E-06, -4.662729327187E-08, 1.885707833825E-10,},
-                              {-5.751755938054E-01, 1.676622419964E-03, -1.568501026478E-03,
-                               5.235042780927E-04, -8.901350181088E-05, 8.437562876296E-06,
-                               -4.722754735716E-07, 1.525662957088E-08, -2.277373255316E-10,},
-                              {1.157406495600E-01, 1.486290009897E-04, -1.404765081110E-04,
-                               1.953433357615E-05, 3.171136646292E-06, -1.281135706652E-06,
-                               1.539182389681E-07, -7.795475709363E-09, 1.408203935795E-10,},
-                              {-1.631671197369E-02, -2.016003370833E-04, 1.639222741263E-04,
-                               -3.782479181914E-05, 2.829273502486E-06, 1.645529677700E-07,
-                               -3.844013350899E-08, 2.070018927471E-09, -3.568996816514E-11,},
-                              {1.362647208936E-03, 3.901702147732E-05, -3.141140575728E-05,
-                               7.810730453019E-06, -7.640509497691E-07, 9.357372398314E-09,
-                               3.398945819263E-09, -2.120439941817E-10, 3.643140818164E-12,},
-                              {-4.908854946631E-05, -2.325049769834E-06, 1.888930116590E-06,
-                               -4.970298877362E-07, 5.607762235203E-08, -2.232480288100E-09,
-                               -6.095037813579E-11, 6.718495301125E-12, -1.229967242093E-13},};
-  Channel_H_RateCoefficient_5=0;
-
-if (NN<=1.0) {
-     for (int i = 0;i <= 8;i++) {
-          Channel_H_RateCoefficient_5 += Channel_H_coeffs_5[i][0]*pow(log(TT),i);
-     }
-     rate_Channel_H = exp(Channel_H_RateCoefficient_5);
-
-}else{
-     for (int i=0;i<=8;i++){
-         for (int j=0;j<=8;j++){
-             Channel_H_RateCoefficient_5 += Channel_H_coeffs_5[i][j]*pow(log(TT),i)*pow(log(NN),j);
-         }
-     }
-     rate_Channel_H = exp(Channel_H_RateCoefficient_5);
-}
-return rate_Channel_H;
-}
-
-///////////channel H(6)//////////////
-BoutReal UpdatedRadiatedPower::Channel_H_6_amjuel(BoutReal T,BoutReal Ne) {
-  if (T < 0.025) {
-    T = 0.025; // 300K
+  return exp(sum);
+}
+} // namespace
+
+BoutReal UpdatedRadiatedPower::Channel_H_2_amjuel(BoutReal T, BoutReal Ne) const {
+  return channelH(channel_h_coeffs[0], ChannelPowers(LogState(T, Ne)));
+}
+
+BoutReal UpdatedRadiatedPower::Channel_H_3_amjuel(BoutReal T, BoutReal Ne) const {
+  return channelH(channel_h_coeffs[1], ChannelPowers(LogState(T, Ne)));
+}
+
+BoutReal UpdatedRadiatedPower::Channel_H_4_amjuel(BoutReal T, BoutReal Ne) const {
+  return channelH(channel_h_coeffs[2], ChannelPowers(LogState(T, Ne)));
+}
+
+BoutReal UpdatedRadiatedPower::Channel_H_5_amjuel(BoutReal T, BoutReal Ne) const {
+  return channelH(channel_h_coeffs[3], ChannelPowers(LogState(T, Ne)));
+}
+
+BoutReal UpdatedRadiatedPower::Channel_H_6_amjuel(BoutReal T, BoutReal Ne) const {
+  return channelH(channel_h_coeffs[4], ChannelPowers(LogState(T, Ne)));
+}
+
+std::array<BoutReal, 5> ExcitedStatePopulations::evaluate(BoutReal T, BoutReal Ne) const {
+  return evaluate(LogState(T, Ne));
+}
+
+std::array<BoutReal, 5> ExcitedStatePopulations::evaluate(const LogState &s) const {
+  const ChannelPowers powers(s);
+  std::array<BoutReal, 5> result;
+  for (int c = 0; c < 5; c++) {
+    result[c] = channelH(channel_h_coeffs[c], powers);
   }
-  double Channel_H_RateCoefficient_6,rate_Channel_H,TT,NN;
-  TT = T;
-  NN=Ne*1.0e-14;
-
-  double Channel_H_coeffs_6[9][9]= {{-3.118788806329E+01, 1.051705868661E+00, -6.954764617920E-02,
-                               2.612329534702E-02, -3.911384137475E-03, 1.474794675693E-04,
-                               9.191757017392E-06, -7.898231632650E-07, 1.514512376570E-08,},
-                              {1.300365034969E+01, 5.806024278787E-02, -7.054107872877E-02,
-                               3.209814487839E-02, -7.336538391803E-03, 8.838327301328E-04,
-                               -5.779085565904E-05, 1.935287412436E-06, -2.603161887414E-08,},
-                              {-6.464611656902E+00, -3.350148712230E-02, 3.809632279775E-02,
-                               -1.663574690203E-02, 3.667522832624E-03, -4.409479869479E-04,
-                               2.975048782418E-05, -1.054940416948E-06, 1.523660684271E-08,},
-                              {2.198690942590E+00, -1.651116960139E-02, 1.248202030331E-02,
-                               -3.600008781362E-03, 5.273464947078E-04, -4.137511227236E-05,
-                               1.553774051571E-06, -1.704433673171E-08, -2.016881015852E-10,},
-                              {-5.762198964354E-01, 8.782966049217E-03, -7.253814512300E-03,
-                               2.434417487959E-03, -4.385057360151E-04, 4.589037396076E-05,
-                               -2.785668187173E-06, 9.065547432614E-08, -1.223436753078E-09,},
-                              {1.190459835777E-01, 7.937734220940E-04, -3.032198147605E-04,
-                               -6.693627833492E-05, 4.755833322780E-05, -8.654363224389E-06,
-                               7.303664535216E-07, -2.952279140710E-08, 4.597194098628E-10,},
-                              {-1.758172528529E-02, -8.425168421647E-04, 4.935184501531E-04,
-                               -8.020637279277E-05, -2.254322145665E-06, 1.858918078917E-06,
-                               -1.970736415814E-07, 8.619751903229E-09, -1.383868509607E-10,},
-                              {1.540671110406E-03, 1.322737632505E-04, -7.161027491097E-05,
-                               9.120131097155E-06, 1.138969748088E-06, -3.791832116704E-07,
-                               3.596045684588E-08, -1.495930494169E-09, 2.332244458469E-11,},
-                              {-5.782468318198E-05, -6.483373521666E-06, 3.088146690349E-06,
-                               -1.704370060355E-07, -1.258928004543E-07, 2.744344149529E-08,
-                               -2.357827363714E-09, 9.371149524100E-11, -1.424213663602E-12,},};
-  Channel_H_RateCoefficient_6=0;
-
-if (NN<=1.0) {
-     for (int i = 0;i <= 8;i++) {
-          Channel_H_RateCoefficient_6 += Channel_H_coeffs_6[i][0]*pow(log(TT),i);
-     }
-     rate_Channel_H = exp(Channel_H_RateCoefficient_6);
-
-}else{
-     for (int i=0;i<=8;i++){
-         for (int j=0;j<=8;j++){
-             Channel_H_RateCoefficient_6 += Channel_H_coeffs_6[i][j]*pow(log(TT),i)*pow(log(NN),j);
-         }
-     }
-     rate_Channel_H = exp(Channel_H_RateCoefficient_6);
-}
-return rate_Channel_H;
+  return result;
+}
+
+BoutReal ExcitedStatePopulations::radiatedPower(BoutReal T, BoutReal Ne) const {
+  return radiatedPower(LogState(T, Ne));
 }
 
+BoutReal ExcitedStatePopulations::radiatedPower(const LogState &s) const {
+  const std::array<BoutReal, 5> populations = evaluate(s);
+  BoutReal result = 0.0;
+  for (int c = 0; c < 5; c++) {
+    result += populations[c] * einstein_A[c] * excited_energy[c];
+  }
+  return result;
+}
@@ -6,46 +6,107 @@
 #include <field3d.hxx>
 #include <bout_types.hxx>
 
-#include <vector>
+#include <array>
 #include <cmath>
+#include <string>
+#include <vector>
+
+/*!
+ * Logarithms of the electron temperature and density at a point,
+ * calculated once and shared by all the rates evaluated there.
+ * Each log is taken once; the others are derived from it.
+ */
+struct LogState {
+  LogState() = default;
+
+  /// Te in eV, Ne in m^-3
+  LogState(BoutReal Te, BoutReal Ne) : Te(Te), Ne(Ne) {
+    // The ADAS tables limit both to 1e-5
+    const BoutReal lnTe = std::log((Te < 1e-5) ? 1e-5 : Te);
+    const BoutReal lnNe = std::log((Ne < 1e-5) ? 1e-5 : Ne);
+    const BoutReal log10e = 0.434294481903251827651; // 1 / ln(10)
+    log10Te = lnTe * log10e;
+    log10Ne = lnNe * log10e;
+
+    // AMJUEL fits limit Te to 0.025 eV (300K), and use Ne in 1e14 m^-3
+    logT = (Te < 0.025) ? std::log(0.025) : lnTe;
+    logN = lnNe - std::log(1e14);
+  }
+
+  BoutReal Te, Ne;         ///< Te [eV] and Ne [m^-3]
+  BoutReal logT;           ///< ln(Te), with Te >= 0.025 eV
+  BoutReal logN;           ///< ln(Ne * 1e-14)
+  BoutReal log10Te, log10Ne; ///< log10 of Te and Ne, both >= 1e-5
+};
 
 class RadiatedPower {
 public:
-  const Field3D power(const Field3D &Te, const Field3D &Ne, const Field3D &Ni);
+  virtual ~RadiatedPower() = default;
+
+  const Field3D power(const Field3D &Te, const Field3D &Ne, const Field3D &Ni) const;
   
-  virtual BoutReal power(BoutReal Te, BoutReal ne, BoutReal ni) = 0;
+  virtual BoutReal power(BoutReal Te, BoutReal ne, BoutReal ni) const = 0;
   
 private:
 };
 
+/*!
+ * Radiated power from a cooling curve in a file. Each line contains
+ * Te [eV] and the radiative loss rate [W m^3], with Te increasing.
+ * Lines starting with # are comments.
+ *
+ * The curve is interpolated in log(Te), log(rate) with monotone
+ * cubic (PCHIP) interpolation, and resampled at load time onto
+ * npoints log-spaced temperatures so that the interval containing
+ * Te is found without a search. Outside the table Te is clamped
+ * to the first or last point.
+ */
 class InterpRadiatedPower : public RadiatedPower {
 public:
-  InterpRadiatedPower(const std::string &file);
+  InterpRadiatedPower(const std::string &file, int npoints = 256);
   
-  BoutReal power(BoutReal Te, BoutReal ne, BoutReal ni);
+  /// Radiated power [W / m^3], for Te in eV and densities in m^-3
+  BoutReal power(BoutReal Te, BoutReal ne, BoutReal ni) const override;
+
+  /// Radiative loss rate [W m^3]
+  BoutReal rate(BoutReal Te) const {
+    BoutReal u = (std::log(Te) - logte_min) * inv_dlogte;
+    u = (u < 0.0) ? 0.0 : ((u > umax) ? umax : u);
+    int i = static_cast<int>(u);
+    if (i == static_cast<int>(coefs.size())) {
+      i--; // Last point
+    }
+    const BoutReal t = u - i;
+    const auto &c = coefs[i];
+    return std::exp(c[0] + t * (c[1] + t * (c[2] + t * c[3])));
+  }
   
 private:
-  std::vector<BoutReal> te_array;  // Te in eV
-  std::vector<BoutReal> p_array;   // Radiative loss rate in Watts m^3
+  BoutReal logte_min;  // log(Te) of the first point
+  BoutReal inv_dlogte; // 1 / spacing in log(Te)
+  BoutReal umax;       // Index of the last point
+  /// Cubic in t = fractional index for log(rate) in each interval
+  std::vector<std::array<BoutReal, 4>> coefs;
 };
 
 
 /// Rates supplied by Eva Havlicova
 class HydrogenRadiatedPower : public RadiatedPower {
 public:
-  BoutReal power(BoutReal Te, BoutReal ne, BoutReal ni);
+  BoutReal power(BoutReal Te, BoutReal ne, BoutReal ni) const;
   
   // Collision rate coefficient <sigma*v> [m3/s]
-  BoutReal ionisation(BoutReal Te);
+  BoutReal ionisation(BoutReal Te) const;
+  BoutReal ionisation(const LogState &s) const;
   
   //<sigma*v> [m3/s]
-  BoutReal recombination(BoutReal n, BoutReal Te);
+  BoutReal recombination(BoutReal n, BoutReal Te) const;
   
   // <sigma*v> [m3/s]
-  BoutReal chargeExchange(BoutReal Te);
+  BoutReal chargeExchange(BoutReal Te) const;
   
   // <sigma*v> [m3/s]
-  BoutReal excitation(BoutReal Te);
+  BoutReal excitation(BoutReal Te) const;
   
 private:
   
@@ -57,39 +118,67 @@ private:
  */
 class UpdatedRadiatedPower : public RadiatedPower {
 public:
-  BoutReal power(BoutReal Te, BoutReal ne, BoutReal ni);  
+  BoutReal power(BoutReal Te, BoutReal ne, BoutReal ni) const;  
+
+  // Rates taking a LogState use its logarithms, rather than taking
+  // their own. The others are the same, evaluated at LogState(T, n)
 
   // Ionisation rate coefficient <sigma*v> [m3/s]
-  BoutReal ionisation(BoutReal Ne, BoutReal T); 
-  BoutReal ionisation_old(BoutReal T);
+  BoutReal ionisation(BoutReal Ne, BoutReal T) const; 
+  BoutReal ionisation(const LogState &s) const;
+  BoutReal ionisation_old(BoutReal T) const;
+  BoutReal ionisation_old(const LogState &s) const;
   
   // Recombination rate coefficient <sigma*v> [m3/s]
-  BoutReal recombination(BoutReal n, BoutReal T);
+  BoutReal recombination(BoutReal n, BoutReal T) const;
+  BoutReal recombination(const LogState &s) const;
   
   // Charge exchange rate coefficient <sigma*v> [m3/s]
-  BoutReal chargeExchange(BoutReal Te);
+  BoutReal chargeExchange(BoutReal Te) const;
+  BoutReal chargeExchange(const LogState &s) const;
   
-  BoutReal excitation(BoutReal Ne, BoutReal Te);
-  BoutReal excitation_old(BoutReal Te);
+  BoutReal excitation(BoutReal Ne, BoutReal Te) const;
+  BoutReal excitation(const LogState &s) const;
+  BoutReal excitation_old(BoutReal Te) const;
   
   // Yulin's neutral excited state population coefficients [Nn(H(n=x)) / Nn(H)]
   // Ratios of excited state to ground state populations.
   // NOTE THAT TEMPERATURE IS FIRST AND DENSITY SECOND OUTPUT
-  BoutReal Channel_H_2_amjuel(BoutReal T,BoutReal Ne);
-  BoutReal Channel_H_3_amjuel(BoutReal T,BoutReal Ne);
-  BoutReal Channel_H_4_amjuel(BoutReal T,BoutReal Ne);
-  BoutReal Channel_H_5_amjuel(BoutReal T,BoutReal Ne);
-  BoutReal Channel_H_6_amjuel(BoutReal T,BoutReal Ne);
+  BoutReal Channel_H_2_amjuel(BoutReal T,BoutReal Ne) const;
+  BoutReal Channel_H_3_amjuel(BoutReal T,BoutReal Ne) const;
+  BoutReal Channel_H_4_amjuel(BoutReal T,BoutReal Ne) const;
+  BoutReal Channel_H_5_amjuel(BoutReal T,BoutReal Ne) const;
+  BoutReal Channel_H_6_amjuel(BoutReal T,BoutReal Ne) const;
   
 private:
   
 };
 
 
+/*!
+ * Populations of the excited states n = 2 to 6 of atomic hydrogen,
+ * relative to the ground state, from AMJUEL H.12 2.1.5b - 2.1.5e
+ * (Yulin Zhou 2022). All five fits share the powers of log(T) and
+ * log(Ne), so are cheaper to evaluate together than with the
+ * UpdatedRadiatedPower::Channel_H_n_amjuel functions.
+ */
+class ExcitedStatePopulations {
+public:
+  /// Nn(n) / Nn(1) for n = 2 to 6, for T in eV and Ne in m^-3
+  std::array<BoutReal, 5> evaluate(BoutReal T, BoutReal Ne) const;
+  std::array<BoutReal, 5> evaluate(const LogState &s) const;
+
+  /// Power radiated by spontaneous decay of the excited states to the
+  /// ground state, per ground state atom [eV/s]:
+  ///   sum_n A_n1 * E_n1 * Nn(n) / Nn(1)
+  BoutReal radiatedPower(BoutReal T, BoutReal Ne) const;
+  BoutReal radiatedPower(const LogState &s) const;
+};
+
 /// Carbon in coronal equilibrium 
 /// From I.H.Hutchinson Nucl. Fusion 34 (10) 1337 - 1348 (1994)
 class HutchinsonCarbonRadiation : public RadiatedPower {
-  BoutReal power(BoutReal Te, BoutReal ne, BoutReal ni) {
+  BoutReal power(BoutReal Te, BoutReal ne, BoutReal ni) const {
     return ne * ni * 2e-31*pow(Te/10., 3) / (1. + pow(Te/10., 4.5));
   }
 };
@@ -0,0 +1,224 @@
+/*
+    This file is part of SD1D.
+
+    SD1D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    SD1D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with SD1D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <mpi.h>
+
+#include "remesh.hxx"
+
+#include <bout/mesh.hxx>
+#include <globals.hxx>
+#include <utils.hxx>
+
+#include <algorithm>
+#include <cmath>
+
+using bout::globals::mesh;
+
+namespace {
+/// Gather equal sized local arrays from all processors along y
+std::vector<BoutReal> allgatherY(const std::vector<BoutReal> &local) {
+  MPI_Comm ycomm = mesh->getYcomm(mesh->xstart);
+  int np;
+  MPI_Comm_size(ycomm, &np);
+
+  std::vector<BoutReal> global(local.size() * np);
+  MPI_Allgather(local.data(), local.size(), MPI_DOUBLE, global.data(),
+                local.size(), MPI_DOUBLE, ycomm);
+  return global;
+}
+
+/// Index in global profiles of the first interior cell on this processor
+int localYOffset() {
+  int rank;
+  MPI_Comm_rank(mesh->getYcomm(mesh->xstart), &rank);
+  return rank * (mesh->yend - mesh->ystart + 1);
+}
+} // namespace
+
+std::vector<BoutReal> gatherY(const Field3D &f) {
+  std::vector<BoutReal> local;
+  for (int j = mesh->ystart; j <= mesh->yend; j++) {
+    local.push_back(f(mesh->xstart, j, 0));
+  }
+  return allgatherY(local);
+}
+
+std::vector<BoutReal> gatherY(const Field2D &f) {
+  std::vector<BoutReal> local;
+  for (int j = mesh->ystart; j <= mesh->yend; j++) {
+    local.push_back(f(mesh->xstart, j));
+  }
+  return allgatherY(local);
+}
+
+void scatterY(const std::vector<BoutReal> &global, Field3D &f) {
+  const int offset = localYOffset() - mesh->ystart;
+  for (int i = mesh->xstart; i <= mesh->xend; i++)
+    for (int j = mesh->ystart; j <= mesh->yend; j++)
+      for (int k = 0; k < mesh->LocalNz; k++) {
+        f(i, j, k) = global[offset + j];
+      }
+}
+
+void scatterY(const std::vector<BoutReal> &global, Field2D &f) {
+  const int offset = localYOffset() - mesh->ystart;
+  for (int i = mesh->xstart; i <= mesh->xend; i++)
+    for (int j = mesh->ystart; j <= mesh->yend; j++) {
+      f(i, j) = global[offset + j];
+    }
+}
+
+std::vector<BoutReal> globalCellEdges() {
+  Coordinates *coord = mesh->getCoordinates();
+
+  std::vector<BoutReal> length = gatherY(coord->dy * sqrt(coord->g_22));
+
+  std::vector<BoutReal> edges(length.size() + 1);
+  edges[0] = 0.0;
+  for (std::size_t i = 0; i < length.size(); i++) {
+    edges[i + 1] = edges[i] + length[i];
+  }
+  return edges;
+}
+
+void setCellEdges(const std::vector<BoutReal> &edges) {
+  Coordinates *coord = mesh->getCoordinates();
+
+  const int offset = localYOffset() - mesh->ystart;
+  for (int i = mesh->xstart; i <= mesh->xend; i++)
+    for (int j = mesh->ystart; j <= mesh->yend; j++) {
+      coord->dy(i, j) =
+          (edges[offset + j + 1] - edges[offset + j]) / sqrt(coord->g_22(i, j));
+    }
+  coord->dy.applyBoundary("neumann");
+  mesh->communicate(coord->dy);
+}
+
+std::vector<BoutReal> remapConservative(const std::vector<BoutReal> &old_edges,
+                                        const std::vector<BoutReal> &values,
+                                        const std::vector<BoutReal> &weight,
+                                        const std::vector<BoutReal> &new_edges) {
+  const int nold = values.size();
+  const int nnew = new_edges.size() - 1;
+
+  std::vector<BoutReal> result(nnew);
+
+  int i = 0; // First old cell which may overlap the new cell
+  for (int k = 0; k < nnew; k++) {
+    BoutReal lo = new_edges[k], hi = new_edges[k + 1];
+
+    while ((i < nold - 1) && (old_edges[i + 1] <= lo)) {
+      i++;
+    }
+
+    BoutReal integral = 0.0, total_weight = 0.0;
+    for (int ii = i; (ii < nold) && (old_edges[ii] < hi); ii++) {
+      BoutReal overlap = std::min(hi, old_edges[ii + 1]) - std::max(lo, old_edges[ii]);
+      if (overlap <= 0.0) {
+        continue;
+      }
+      integral += values[ii] * weight[ii] * overlap;
+      total_weight += weight[ii] * overlap;
+    }
+
+    result[k] = (total_weight > 0.0) ? integral / total_weight : values[i];
+  }
+  return result;
+}
+
+std::vector<BoutReal> gradientMonitor(const std::vector<BoutReal> &edges,
+                                      const std::vector<std::vector<BoutReal>> &profiles,
+                                      BoutReal alpha, int smoothing,
+                                      BoutReal min_fraction) {
+  const int n = edges.size() - 1;
+  const BoutReal length = edges[n] - edges[0];
+
+  std::vector<BoutReal> centre(n);
+  for (int i = 0; i < n; i++) {
+    centre[i] = 0.5 * (edges[i] + edges[i + 1]);
+  }
+
+  std::vector<BoutReal> sum(n, 0.0);
+  for (const auto &f : profiles) {
+    BoutReal scale = 0.0;
+    for (const auto &val : f) {
+      scale = std::max(scale, fabs(val));
+    }
+    if (scale <= 0.0) {
+      continue;
+    }
+    for (int i = 0; i < n; i++) {
+      int il = std::max(i - 1, 0), ir = std::min(i + 1, n - 1);
+      BoutReal gradient = (f[ir] - f[il]) / (centre[ir] - centre[il]);
+      sum[i] += SQ(gradient * length / scale);
+    }
+  }
+
+  std::vector<BoutReal> monitor(n);
+  for (int i = 0; i < n; i++) {
+    monitor[i] = sqrt(1. + alpha * sum[i]);
+  }
+
+  for (int s = 0; s < smoothing; s++) {
+    std::vector<BoutReal> last = monitor;
+    for (int i = 0; i < n; i++) {
+      int il = std::max(i - 1, 0), ir = std::min(i + 1, n - 1);
+      monitor[i] = 0.25 * last[il] + 0.5 * last[i] + 0.25 * last[ir];
+    }
+  }
+
+  if (min_fraction > 0.0) {
+    // Equidistributed cell size is (length / n) * (mean / M)
+    // so limit M to be at most mean / min_fraction
+    BoutReal mean = 0.0;
+    for (int i = 0; i < n; i++) {
+      mean += monitor[i] * (edges[i + 1] - edges[i]);
+    }
+    mean /= length;
+    for (auto &m : monitor) {
+      m = std::min(m, mean / min_fraction);
+    }
+  }
+  return monitor;
+}
+
+std::vector<BoutReal> equidistribute(const std::vector<BoutReal> &edges,
+                                     const std::vector<BoutReal> &monitor) {
+  const int n = monitor.size();
+
+  // Cumulative integral of the monitor function at old cell edges
+  std::vector<BoutReal> cumulative(n + 1);
+  cumulative[0] = 0.0;
+  for (int i = 0; i < n; i++) {
+    cumulative[i + 1] = cumulative[i] + monitor[i] * (edges[i + 1] - edges[i]);
+  }
+
+  std::vector<BoutReal> new_edges(n + 1);
+  new_edges[0] = edges[0];
+  new_edges[n] = edges[n];
+
+  int i = 0;
+  for (int k = 1; k < n; k++) {
+    BoutReal target = k * cumulative[n] / n;
+    while ((i < n - 1) && (cumulative[i + 1] < target)) {
+      i++;
+    }
+    // Monitor is constant in each cell, so the integral is linear
+    new_edges[k] = edges[i] + (target - cumulative[i]) / monitor[i];
+  }
+  return new_edges;
+}
@@ -0,0 +1,113 @@
+/*
+  Redistribution of grid cells along y, and conservative remapping
+  of profiles between grids
+
+    This file is part of SD1D.
+
+    SD1D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    SD1D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with SD1D.  If not, see <http://www.gnu.org/licenses/>.
+
+  The model is one-dimensional, so profiles are taken at x = xstart, z = 0
+  and global profiles contain only the interior (non-guard) cells, in order
+  of increasing y over all processors.
+ */
+
+#ifndef __REMESH_H__
+#define __REMESH_H__
+
+#include <field2d.hxx>
+#include <field3d.hxx>
+
+#include <vector>
+
+/*!
+ * Gather the interior cells of a field along y from all processors.
+ * The result is the same on all processors
+ */
+std::vector<BoutReal> gatherY(const Field3D &f);
+std::vector<BoutReal> gatherY(const Field2D &f);
+
+/*!
+ * Set the interior cells of a field from a global profile, such as
+ * one returned by gatherY. The value is used for all x and z.
+ * Guard cells are not modified
+ */
+void scatterY(const std::vector<BoutReal> &global, Field3D &f);
+void scatterY(const std::vector<BoutReal> &global, Field2D &f);
+
+/*!
+ * Positions of the global cell edges, measured as (normalised) length
+ * along the field from the lower (upstream) boundary: dy * sqrt(g_22).
+ * There is one more edge than the number of cells.
+ */
+std::vector<BoutReal> globalCellEdges();
+
+/*!
+ * Set the grid spacing dy so that cells have the given global edges.
+ * Guard cells are set to zero gradient at boundaries, and communicated
+ * between processors. Derived geometry is not recalculated.
+ *
+ * @param[in] edges  Global cell edges, as returned by globalCellEdges
+ */
+void setCellEdges(const std::vector<BoutReal> &edges);
+
+/*!
+ * Remap cell averages from one grid to another, conserving the
+ * weighted integral
+ *
+ *   sum( f * weight * length )
+ *
+ * Each new cell value is the weighted average of the old cell values
+ * which overlap it. If weight is the Jacobian J then the volume integral
+ * is conserved. Where the grids don't overlap the nearest old value is used.
+ *
+ * @param[in] old_edges  Cell edges of the old grid (size N+1)
+ * @param[in] values     Old cell averages (size N)
+ * @param[in] weight     Old cell weights (size N)
+ * @param[in] new_edges  Cell edges of the new grid
+ */
+std::vector<BoutReal> remapConservative(const std::vector<BoutReal> &old_edges,
+                                        const std::vector<BoutReal> &values,
+                                        const std::vector<BoutReal> &weight,
+                                        const std::vector<BoutReal> &new_edges);
+
+/*!
+ * Grid density monitor function, based on gradients of the profiles
+ *
+ *   M = sqrt( 1 + alpha * sum_f ( L / max|f| * df/dl )^2 )
+ *
+ * where L is the domain length. Cells are small where M is large.
+ *
+ * @param[in] edges     Global cell edges
+ * @param[in] profiles  Global profiles of cell averages
+ * @param[in] alpha     Weight of the gradients, compared to uniform spacing
+ * @param[in] smoothing Number of (1,2,1) smoothing passes
+ * @param[in] min_fraction  Minimum cell size, as a fraction of the uniform size.
+ *                          Not limited if <= 0
+ */
+std::vector<BoutReal> gradientMonitor(const std::vector<BoutReal> &edges,
+                                      const std::vector<std::vector<BoutReal>> &profiles,
+                                      BoutReal alpha, int smoothing,
+                                      BoutReal min_fraction);
+
+/*!
+ * Calculate new cell edges which equidistribute the monitor function,
+ * keeping the same number of cells and the same domain.
+ *
+ * @param[in] edges    Global cell edges
+ * @param[in] monitor  Monitor function, constant in each cell. Must be > 0
+ */
+std::vector<BoutReal> equidistribute(const std::vector<BoutReal> &edges,
+                                     const std::vector<BoutReal> &monitor);
+
+#endif // __REMESH_H__
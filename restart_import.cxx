@@ -0,0 +1,267 @@
+/*
+    This file is part of SD1D.
+
+    SD1D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    SD1D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with SD1D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "restart_import.hxx"
+
+#include <boutcomm.hxx>
+#include <boutexception.hxx>
+#include <output.hxx>
+
+#include <cmath>
+
+#include <mpi.h>
+
+#ifdef NCDF4
+#include <netcdf.h>
+#endif
+
+namespace {
+#ifdef NCDF4
+/// Throw an exception if a NetCDF call failed
+void check(int status, const std::string &what) {
+  if (status != NC_NOERR) {
+    throw BoutException("importProfiles: %s: %s", what.c_str(), nc_strerror(status));
+  }
+}
+
+/// Read an integer scalar, or return the default if not in the file
+int readInt(int ncid, const std::string &name, int def) {
+  int varid;
+  if (nc_inq_varid(ncid, name.c_str(), &varid) != NC_NOERR) {
+    return def;
+  }
+  int value;
+  check(nc_get_var_int(ncid, varid, &value), name);
+  return value;
+}
+
+/*!
+ * Read the interior y cells of a field at x = mxg, z = 0, from the last
+ * time if the field has a time dimension. Returns false if the
+ * field is not in the file
+ */
+bool readProfile(int ncid, const std::string &name, int mxg, int myg,
+                 std::vector<BoutReal> &result) {
+  int varid;
+  if (nc_inq_varid(ncid, name.c_str(), &varid) != NC_NOERR) {
+    return false;
+  }
+  int ndims;
+  check(nc_inq_varndims(ncid, varid, &ndims), name);
+  if ((ndims < 2) || (ndims > 4)) {
+    throw BoutException("importProfiles: %s has %d dimensions", name.c_str(), ndims);
+  }
+  int dimids[4];
+  check(nc_inq_vardimid(ncid, varid, dimids), name);
+
+  // Dimensions are named t, x, y, z. Fields may be 2D or 3D, with or
+  // without time
+  size_t start[4] = {0, 0, 0, 0};
+  size_t count[4] = {1, 1, 1, 1};
+  size_t ny = 0;
+  for (int d = 0; d < ndims; d++) {
+    char dimname[NC_MAX_NAME + 1];
+    size_t len;
+    check(nc_inq_dim(ncid, dimids[d], dimname, &len), name);
+    const std::string dim = dimname;
+    if (dim == "t") {
+      start[d] = len - 1; // Last time
+    } else if (dim == "x") {
+      start[d] = mxg;
+    } else if (dim == "y") {
+      ny = len;
+      count[d] = len;
+    }
+  }
+  if (ny <= 2 * static_cast<size_t>(myg)) {
+    throw BoutException("importProfiles: %s has no interior cells", name.c_str());
+  }
+
+  std::vector<double> data(ny);
+  check(nc_get_vara_double(ncid, varid, start, count, data.data()), name);
+  result.insert(result.end(), data.begin() + myg, data.end() - myg);
+  return true;
+}
+#endif
+
+/// Copy a vector from processor 0 to all processors
+void broadcast(std::vector<BoutReal> &v) {
+  int size = static_cast<int>(v.size());
+  MPI_Bcast(&size, 1, MPI_INT, 0, BoutComm::get());
+  v.resize(size);
+  MPI_Bcast(v.data(), size, MPI_DOUBLE, 0, BoutComm::get());
+}
+
+/// Copy an error message from processor 0 to all processors, and throw
+/// an exception on all processors if it is not empty
+void broadcastError(std::string message) {
+  int size = static_cast<int>(message.size());
+  MPI_Bcast(&size, 1, MPI_INT, 0, BoutComm::get());
+  if (size == 0) {
+    return;
+  }
+  message.resize(size);
+  MPI_Bcast(&message[0], size, MPI_CHAR, 0, BoutComm::get());
+  throw BoutException("%s", message.c_str());
+}
+} // namespace
+
+ImportedProfiles importProfiles(const std::string &path, const std::string &prefix,
+                                const std::vector<std::string> &fields,
+                                const std::vector<std::string> &scalars) {
+  ImportedProfiles result;
+
+#ifdef NCDF4
+  std::vector<BoutReal> length;
+
+  // Files are only read on processor 0, so errors there are passed to
+  // the other processors before they wait for the data
+  std::string error;
+  if (BoutComm::rank() == 0) {
+    try {
+      for (int n = 0;; n++) {
+        std::string filename = path + "/" + prefix + "." + std::to_string(n) + ".nc";
+        int ncid;
+        if (nc_open(filename.c_str(), NC_NOWRITE, &ncid) != NC_NOERR) {
+          if (n == 0) {
+            throw BoutException("importProfiles: Couldn't open %s", filename.c_str());
+          }
+          break;
+        }
+        output_info.write("\tImporting profiles from %s\n", filename.c_str());
+
+        try {
+          if (readInt(ncid, "NXPE", 1) != 1) {
+            throw BoutException("importProfiles: %s has more than one processor in x",
+                                filename.c_str());
+          }
+          const int mxg = readInt(ncid, "MXG", 2);
+          const int myg = readInt(ncid, "MYG", 2);
+
+          // Cell lengths. Constant factors cancel, since edges are
+          // fractions of the total length
+          const std::size_t ncells = length.size();
+          std::vector<BoutReal> dy, g_22;
+          if (readProfile(ncid, "dy_adapt", mxg, myg, dy)
+              || readProfile(ncid, "dy", mxg, myg, dy)) {
+            if (readProfile(ncid, "g_22", mxg, myg, g_22)) {
+              for (std::size_t i = 0; i < dy.size(); i++) {
+                dy[i] *= std::sqrt(g_22[i]);
+              }
+            }
+            length.insert(length.end(), dy.begin(), dy.end());
+          }
+
+          if (!readProfile(ncid, "J", mxg, myg, result.J)) {
+            result.J.resize(result.J.size() + dy.size(), 1.0);
+          }
+
+          for (const auto &name : fields) {
+            if ((n > 0) && (result.fields.count(name) == 0)) {
+              continue; // Not in the first file
+            }
+            if (!readProfile(ncid, name, mxg, myg, result.fields[name])) {
+              if (n > 0) {
+                throw BoutException("importProfiles: %s not in %s", name.c_str(),
+                                    filename.c_str());
+              }
+              result.fields.erase(name);
+              continue;
+            }
+            const std::size_t size = result.fields[name].size();
+            if (dy.empty() && (length.size() < size)) {
+              // No grid spacing in the file: cells are uniform
+              length.resize(size, 1.0);
+              result.J.resize(size, 1.0);
+            }
+          }
+          if (length.size() == ncells) {
+            throw BoutException("importProfiles: No cells read from %s",
+                                filename.c_str());
+          }
+
+          if (n == 0) {
+            for (const auto &name : scalars) {
+              int varid;
+              if (nc_inq_varid(ncid, name.c_str(), &varid) == NC_NOERR) {
+                double value;
+                check(nc_get_var_double(ncid, varid, &value), name);
+                result.scalars[name] = value;
+              }
+            }
+          }
+        } catch (...) {
+          nc_close(ncid);
+          throw;
+        }
+        nc_close(ncid);
+      }
+
+      for (const auto &field : result.fields) {
+        if (field.second.size() != length.size()) {
+          throw BoutException("importProfiles: %s has %d cells, but the grid has %d",
+                              field.first.c_str(), static_cast<int>(field.second.size()),
+                              static_cast<int>(length.size()));
+        }
+      }
+    } catch (const std::exception &e) {
+      error = e.what();
+    }
+  }
+  broadcastError(error);
+
+  broadcast(length);
+  broadcast(result.J);
+  result.edges.resize(length.size() + 1, 0.0);
+  for (std::size_t i = 0; i < length.size(); i++) {
+    result.edges[i + 1] = result.edges[i] + length[i];
+  }
+  const BoutReal total = result.edges.back();
+  for (auto &edge : result.edges) {
+    edge /= total;
+  }
+
+  // Missing fields and scalars have size zero
+  for (const auto &name : fields) {
+    std::vector<BoutReal> &values = result.fields[name];
+    broadcast(values);
+    if (values.empty()) {
+      result.fields.erase(name);
+    }
+  }
+  for (const auto &name : scalars) {
+    std::vector<BoutReal> value;
+    if (result.scalars.count(name) > 0) {
+      value.push_back(result.scalars[name]);
+    }
+    broadcast(value);
+    if (value.empty()) {
+      result.scalars.erase(name);
+    } else {
+      result.scalars[name] = value[0];
+    }
+  }
+#else
+  (void)path;
+  (void)prefix;
+  (void)fields;
+  (void)scalars;
+  throw BoutException("importProfiles: BOUT++ must be built with NetCDF-4");
+#endif
+
+  return result;
+}
@@ -0,0 +1,69 @@
+/*
+  Read profiles from the output of another run, which may have a
+  different resolution, grid spacing, length or number of processors
+
+    This file is part of SD1D.
+
+    SD1D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    SD1D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with SD1D.  If not, see <http://www.gnu.org/licenses/>.
+
+  As in remesh.hxx, profiles are global and one-dimensional: the
+  interior cells at x = MXG, z = 0, in order of increasing y over all
+  processors of the old run.
+ */
+
+#ifndef __RESTART_IMPORT_H__
+#define __RESTART_IMPORT_H__
+
+#include <bout_types.hxx>
+
+#include <map>
+#include <string>
+#include <vector>
+
+struct ImportedProfiles {
+  /// Old cell edges, as a fraction of the total length, from 0 (upstream)
+  /// to 1 (target). From dy * sqrt(g_22) if in the files, otherwise
+  /// dy_adapt or dy, otherwise uniform
+  std::vector<BoutReal> edges;
+
+  /// Old Jacobian in each cell, or 1 if not in the files
+  std::vector<BoutReal> J;
+
+  /// Old cell values of each field found in the files
+  std::map<std::string, std::vector<BoutReal>> fields;
+
+  /// Scalars found in the first file
+  std::map<std::string, BoutReal> scalars;
+};
+
+/*!
+ * Read profiles from <path>/<prefix>.<n>.nc, for n = 0, 1, ... until a
+ * file doesn't exist. These are restart files (prefix = "BOUT.restart")
+ * or dump files ("BOUT.dmp"), in which case the last time is used.
+ * The old run must have had one processor in x.
+ *
+ * Files are read on one processor, and the result is the same on all.
+ * If reading fails, a BoutException is thrown on all processors.
+ * Requires BOUT++ to be built with NetCDF-4 (NCDF4).
+ *
+ * @param[in] path     Directory containing the files
+ * @param[in] prefix   File name before the processor number
+ * @param[in] fields   Names of fields to read. Missing fields are skipped
+ * @param[in] scalars  Names of scalars to read. Missing scalars are skipped
+ */
+ImportedProfiles importProfiles(const std::string &path, const std::string &prefix,
+                                const std::vector<std::string> &fields,
+                                const std::vector<std::string> &scalars);
+
+#endif // __RESTART_IMPORT_H__
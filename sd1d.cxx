@@ -35,6 +35,16 @@
  */
 
 #include <mpi.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "revision.hxx"
 
@@ -45,9 +55,14 @@
 #include <invert_parderiv.hxx>
 #include <bout/snb.hxx>
 #include <bout/fv_ops.hxx>
+#include <bout/openmpwrap.hxx>
 
+#include "diagnostic_writer.hxx"
 #include "div_ops.hxx"
 #include "loadmetric.hxx"
+#include "remesh.hxx"
+#include "restart_import.hxx"
+#include "section_timer.hxx"
 #include "radiation.hxx"
 
 // OpenADAS interface Atomicpp by T.Body
@@ -71,6 +86,105 @@ protected:
     dump.setAttribute("", "SD1D_REVISION", sd1d::version::revision);
 
     OPTION(opt, cfl_info, false); // Calculate and print CFL information
+    if (cfl_info) {
+      cfl_dt = 0.0;
+      cfl_process = 0.0;
+      SAVE_REPEAT2(cfl_dt, cfl_process);
+      for (int c = 0; c < NCFL; c++) {
+        dump.addRepeat(cfl_limit[c], "cfl_" + cfl_names[c]);
+      }
+    }
+
+    // Load balance information
+    balance_info = opt["balance_info"]
+                       .doc("Time rhs on each processor and suggest y "
+                            "partitions which balance the cost")
+                       .withDefault<bool>(false);
+    balance_by_nn = opt["balance_by_nn"]
+                        .doc("Distribute atomic physics cost between cells in "
+                             "proportion to neutral density, rather than "
+                             "uniformly")
+                        .withDefault<bool>(true);
+    if (balance_info) {
+      SAVE_REPEAT3(rhs_wall_time, atomic_wall_time, load_imbalance);
+    }
+
+    // Threads on each processor, for hybrid MPI + OpenMP runs
+    int num_threads = opt["num_threads"]
+                          .doc("Number of OpenMP threads on each processor. "
+                               "If <= 0, set by OMP_NUM_THREADS")
+                          .withDefault<int>(0);
+    std::string thread_schedule =
+        opt["thread_schedule"]
+            .doc("OpenMP schedule of the atomic rate loops: static, "
+                 "dynamic or guided")
+            .withDefault<std::string>("static");
+    int thread_chunk = opt["thread_chunk"]
+                           .doc("Cells in each chunk of the thread schedule. "
+                                "If <= 0, the OpenMP default")
+                           .withDefault<int>(0);
+#ifdef _OPENMP
+    if (num_threads > 0) {
+      omp_set_num_threads(num_threads);
+    }
+    omp_sched_t schedule_kind;
+    if (thread_schedule == "static") {
+      schedule_kind = omp_sched_static;
+    } else if (thread_schedule == "dynamic") {
+      schedule_kind = omp_sched_dynamic;
+    } else if (thread_schedule == "guided") {
+      schedule_kind = omp_sched_guided;
+    } else {
+      throw BoutException("Unrecognised thread_schedule '%s'",
+                          thread_schedule.c_str());
+    }
+    omp_set_schedule(schedule_kind, thread_chunk);
+    output.write("\tUsing %d OpenMP threads, %s schedule\n", omp_get_max_threads(),
+                 thread_schedule.c_str());
+#else
+    if (num_threads > 1) {
+      output_warn.write("\tnum_threads ignored: SD1D compiled without OpenMP\n");
+    }
+#endif
+
+    // Time spent in sections of rhs
+    rhs_profile = opt["rhs_profile"]
+                      .doc("Save and print the time spent in each section of "
+                           "rhs (min, mean and max over processors)")
+                      .withDefault<bool>(false);
+    if (rhs_profile) {
+      rhs_timer.addToDump(dump, "time_");
+    }
+
+    // Number of guard cell exchanges in the last rhs call
+    SAVE_REPEAT(rhs_exchanges);
+
+    // Solver statistics for each output interval
+    solver_info = opt["solver_info"]
+                      .doc("Print solver statistics at each output")
+                      .withDefault<bool>(false);
+    SAVE_REPEAT4(rhs_calls, precon_calls, solver_steps, step_failures);
+    SAVE_REPEAT2(mean_timestep, wall_per_simtime);
+
+    // Counts of cells where floors and limits are applied
+    clamp_info = opt["clamp_info"]
+                     .doc("Print the number of cells where floors and limits "
+                          "were applied at each output")
+                     .withDefault<bool>(false);
+    clamp_masks = opt["clamp_masks"]
+                      .doc("Save the fraction of rhs calls in which each cell "
+                           "was clamped")
+                      .withDefault<bool>(false);
+    for (int c = 0; c < NCLAMP; c++) {
+      dump.addRepeat(clamp_total[c], "clamp_" + clamp_names[c]);
+    }
+    if (clamp_masks) {
+      for (int c = 0; c < NCLAMP_CELL; c++) {
+        clamp_mask[c] = 0.0;
+        clamp_fraction[c] = 0.0;
+        dump.addRepeat(clamp_fraction[c], "clamp_mask_" + clamp_names[c]);
+      }
+    }
 
     // Normalisation
     OPTION(opt, Tnorm, 100);             // Reference temperature [eV]
@@ -125,6 +239,21 @@ protected:
     kappa_limit_alpha = opt["kappa_limit_alpha"]
                             .doc("Flux limiter. Turned off if < 0 (default)")
                             .withDefault(-1.0);
+    if (heat_conduction && (kappa_limit_alpha > 0.0)) {
+      // The flux limiter calculates Grad_par(Te) in guard cells with
+      // central differences, which must match Grad_par on the neighbouring
+      // processor so that kappa_epar is the same on both.
+      // Depending on version BOUT++ reads [mesh:ddy] or [ddy], so check both
+      for (const std::string section : {"mesh:ddy", "ddy"}) {
+        Options &ddy = (section == "ddy") ? Options::root()["ddy"]
+                                          : Options::root()["mesh"]["ddy"];
+        const std::string ddy_first = ddy["first"].withDefault<std::string>("C2");
+        if (lowercase(ddy_first) != "c2") {
+          throw BoutException("kappa_limit_alpha requires %s:first = C2, not %s",
+                              section.c_str(), ddy_first.c_str());
+        }
+      }
+    }
 
     snb_model = opt["snb_model"]
                     .doc("Use SNB non-local heat flux model")
@@ -133,6 +262,15 @@ protected:
       // Create a solver to calculate the SNB heat flux
       snb = new HeatFluxSNB();
     }
+    snb_lag_calls = opt["snb_lag_calls"]
+                        .doc("Recalculate the SNB correction at least every "
+                             "this many rhs calls")
+                        .withDefault<int>(1);
+    snb_lag_tol = opt["snb_lag_tol"]
+                      .doc("Recalculate the SNB correction when Te changes by "
+                           "more than this fraction. Not used if <= 0")
+                      .withDefault(0.0);
+    snb_lagged = snb_model && ((snb_lag_calls > 1) || (snb_lag_tol > 0.0));
     
     OPTION(opt, charge_exchange, true);
     OPTION(opt, charge_exchange_escape, false);
@@ -155,6 +293,12 @@ protected:
     OPTION(opt, ex_rate, "default"); // Set to "solkit" to enable rate H.10 2.1.5 used in SOLPS and in SOLKiT 
     OPTION(opt, dn_model, "default"); // Set to "solkit" to enable SOLKiT neutral diffusion
     OPTION(opt, cx_model, "default"); // Set to "solkit" to enable SOLKiT charge exchange friction
+    // Compared once here rather than in every cell
+    iz_solkit = (iz_rate == "solkit");
+    ex_solkit = (ex_rate == "solkit");
+    ex_population = (ex_rate == "population");
+    dn_solkit = (dn_model == "solkit");
+    cx_solkit = (cx_model == "solkit");
     OPTION(opt, atomic_debug, false); // Save Siz_compare and Rex_compare which correspond to SD1D default Siz & Rex 
     OPTION(opt, dn_debug, false); // Save neutral diffusion equation terms
     OPTION(opt, tn_3ev, false); // Force neutral temperature to 3eV. This affects the Eiz channel.
@@ -280,14 +424,18 @@ protected:
     solver->add(Ne, "Ne");
     solver->add(NVi, "NVi");
     solver->add(P, "P");
+    evolving = {{"Ne", &Ne}, {"NVi", &NVi}, {"P", &P}};
 
     if (atomic) {
       solver->add(Nn, "Nn");
+      evolving.push_back({"Nn", &Nn});
       if (evolve_nvn) {
         solver->add(NVn, "NVn");
+        evolving.push_back({"NVn", &NVn});
       }
       if (evolve_pn) {
         solver->add(Pn, "Pn");
+        evolving.push_back({"Pn", &Pn});
       }
     }
 
@@ -307,15 +455,34 @@ protected:
     OPTION(opt, fimp, 0.0); // Fixed impurity fraction
 
     OPTION(opt, impurity_adas, false);
+    string impurity_model = opt["impurity_model"]
+                                .doc("Impurity radiation: hutchinson (carbon), "
+                                     "adas, or table (cooling curve in a file)")
+                                .withDefault<string>(impurity_adas ? "adas"
+                                                                   : "hutchinson");
+    impurity_adas = (impurity_model == "adas");
     if (impurity_adas) {
       // Use OpenADAS data through Atomicpp
       // Find out which species to model
       string impurity_species;
       OPTION(opt, impurity_species, "c");
       impurity = new ImpuritySpecies(impurity_species);
-    } else {
+    } else if (impurity_model == "table") {
+      // Cooling curve Lz(Te) from a file
+      string impurity_table = opt["impurity_table"]
+                                  .doc("File containing Te [eV] and radiative "
+                                       "loss rate [W m^3] on each line")
+                                  .withDefault<string>("cooling_curve.txt");
+      int impurity_table_points = opt["impurity_table_points"]
+                                      .doc("Number of log-spaced points the "
+                                           "table is resampled onto")
+                                      .withDefault(256);
+      rad = new InterpRadiatedPower(impurity_table, impurity_table_points);
+    } else if (impurity_model == "hutchinson") {
       // Use carbon radiation for the impurity
       rad = new HutchinsonCarbonRadiation();
+    } else {
+      throw BoutException("Unknown impurity_model '%s'", impurity_model.c_str());
     }
 
     // Add extra quantities to be saved
@@ -333,62 +500,141 @@ protected:
       if (snb_model) {
         SAVE_REPEAT(Div_Q_SH, Div_Q_SNB);
       }
+      if (snb_lagged) {
+        SAVE_REPEAT(snb_updates);
+      }
     }
     
     bool diagnose;
     OPTION(opt, diagnose, true);
+
+    // Volume integrals, target and upstream values, saved as scalars
+    reduced_diagnostics =
+        opt["reduced_diagnostics"]
+            .doc("Save integrated power, particle and momentum balances, "
+                 "target and upstream values and front position at each output")
+            .withDefault<bool>(true);
+    front_te = opt["front_te"]
+                   .doc("Temperature [eV] defining the front position")
+                   .withDefault(5.0);
+    if (reduced_diagnostics) {
+      SAVE_REPEAT4(power_input, power_radiated, power_impurity, power_neutrals);
+      SAVE_REPEAT4(power_target, radiated_fraction, power_residual, target_flux);
+      SAVE_REPEAT3(particle_input, ionisation_rate, recombination_rate);
+      SAVE_REPEAT(momentum_loss_fraction);
+      SAVE_REPEAT4(upstream_te, upstream_ne, target_te, target_ne);
+      SAVE_REPEAT(front_position);
+    }
+
+    // Stop when the solution is steady
+    stop_on_convergence =
+        opt["stop_on_convergence"]
+            .doc("Write restart files and stop when Ne, P, Nn and the power "
+                 "balance have converged")
+            .withDefault<bool>(false);
+    stop_rtol_ne = opt["stop_rtol_ne"]
+                       .doc("Maximum relative change in Ne between outputs")
+                       .withDefault(1e-4);
+    stop_rtol_p = opt["stop_rtol_p"]
+                      .doc("Maximum relative change in P between outputs")
+                      .withDefault(1e-4);
+    stop_rtol_nn = opt["stop_rtol_nn"]
+                       .doc("Maximum relative change in Nn between outputs")
+                       .withDefault(1e-4);
+    stop_power_residual = opt["stop_power_residual"]
+                              .doc("Maximum power balance residual, as a "
+                                   "fraction of input power. Not used if <= 0")
+                              .withDefault(0.05);
+    stop_consecutive = opt["stop_consecutive"]
+                           .doc("Number of consecutive converged outputs "
+                                "before stopping")
+                           .withDefault<int>(3);
+    if (stop_on_convergence) {
+      SAVE_REPEAT3(change_ne, change_p, change_nn);
+    }
+
+    // Diagnostics are added to the dump file, or written separately
+    // with compression and decimation. See diagnostic_writer.hxx
+    diagnostics.reset(new DiagnosticWriter(Options::root()["diagnostics"]));
+    auto saveDiagnostic = [&](Field3D &f, const std::string &name) {
+      diagnostics->add(f, name, dump);
+    };
+
     if (diagnose) {
       // Output extra variables
       if (atomic) {
-        SAVE_REPEAT2(Srec, Siz);        // Save particle sources
-        SAVE_REPEAT3(Frec, Fiz, Fcx);   // Save momentum sources
-        SAVE_REPEAT3(Rrec, Riz, Rzrad); // Save radiation sources
-        SAVE_REPEAT3(Erec, Eiz, Ecx);   // Save energy transfer
+        // Save particle sources
+        saveDiagnostic(Srec, "Srec");
+        saveDiagnostic(Siz, "Siz");
+        // Save momentum sources
+        saveDiagnostic(Frec, "Frec");
+        saveDiagnostic(Fiz, "Fiz");
+        saveDiagnostic(Fcx, "Fcx");
+        // Save radiation sources
+        saveDiagnostic(Rrec, "Rrec");
+        saveDiagnostic(Riz, "Riz");
+        saveDiagnostic(Rzrad, "Rzrad");
+        // Save energy transfer
+        saveDiagnostic(Erec, "Erec");
+        saveDiagnostic(Eiz, "Eiz");
+        saveDiagnostic(Ecx, "Ecx");
         if (charge_exchange_escape) {
-          SAVE_REPEAT2(Dcx, Dcx_T); // Save particle loss of CX neutrals
+          // Save particle loss of CX neutrals
+          saveDiagnostic(Dcx, "Dcx");
+          saveDiagnostic(Dcx_T, "Dcx_T");
         }
 
         if (elastic_scattering) {
-          SAVE_REPEAT2(Fel, Eel); // Elastic collision transfer channels
+          // Elastic collision transfer channels
+          saveDiagnostic(Fel, "Fel");
+          saveDiagnostic(Eel, "Eel");
         }
         if (excitation) {
-          SAVE_REPEAT(Rex); // Electron-neutral excitation
+          saveDiagnostic(Rex, "Rex"); // Electron-neutral excitation
         }
 
         if (evolve_nvn) {
-          SAVE_REPEAT(Vn);
+          saveDiagnostic(Vn, "Vn");
         }
 
         // Rate diagnostics [MK]
         if (atomic_debug) {
-            SAVE_REPEAT2(Siz_compare, Rex_compare);
+            saveDiagnostic(Siz_compare, "Siz_compare");
+            saveDiagnostic(Rex_compare, "Rex_compare");
         }
         // Neutral diffusion diagnostics [MK]
         if (dn_debug) {
-            SAVE_REPEAT4(dn_sigma_cx, dn_sigma_iz, dn_sigma_nn, dn_vth_n);
+            saveDiagnostic(dn_sigma_cx, "dn_sigma_cx");
+            saveDiagnostic(dn_sigma_iz, "dn_sigma_iz");
+            saveDiagnostic(dn_sigma_nn, "dn_sigma_nn");
+            saveDiagnostic(dn_vth_n, "dn_vth_n");
         }
         // Additional terms [MK]
         if (include_braginskii_rt) {
-            SAVE_REPEAT2(Ert, gradT);
+            saveDiagnostic(Ert, "Ert");
+            saveDiagnostic(gradT, "gradT");
         }
         if (read_fcx_exc) {
-            SAVE_REPEAT(Fcx_exc);
+            saveDiagnostic(Fcx_exc, "Fcx_exc");
         }
         if (read_frec_sk) {
-            SAVE_REPEAT(Frec_sk);
+            saveDiagnostic(Frec_sk, "Frec_sk");
         }
       }
 
-      SAVE_REPEAT(Vi);
-      SAVE_REPEAT(Te); // MK addition
+      saveDiagnostic(Vi, "Vi");
+      saveDiagnostic(Te, "Te"); // MK addition
     }
 
     if ( opt["output_ddt"].withDefault<bool>(false) ) {
-      SAVE_REPEAT(ddt(Ne), ddt(P), ddt(NVi));
+      saveDiagnostic(ddt(Ne), "ddt(Ne)");
+      saveDiagnostic(ddt(P), "ddt(P)");
+      saveDiagnostic(ddt(NVi), "ddt(NVi)");
       if (atomic) {
-        SAVE_REPEAT(ddt(Nn), ddt(Pn));
+        saveDiagnostic(ddt(Nn), "ddt(Nn)");
+        saveDiagnostic(ddt(Pn), "ddt(Pn)");
         if (evolve_nvn) {
-          SAVE_REPEAT(ddt(NVn));
+          saveDiagnostic(ddt(NVn), "ddt(NVn)");
         }
       }
     }
@@ -526,10 +772,157 @@ protected:
     if (!split_operator) {
       // Turn on all terms in rhs
       rhs_explicit = rhs_implicit = true;
+      rhs_atomic = true;
       update_coefficients = true;
     }
     setSplitOperator(split_operator);
 
+    freeze_coefficients =
+        opt["freeze_coefficients"]
+            .doc("Recalculate transport coefficients only at the first rhs "
+                 "call at each time, i.e. the start of each nonlinear solve")
+            .withDefault<bool>(false);
+
+    // Atomic source terms are usually in the explicit part. Moving them
+    // to the implicit part allows timesteps longer than the atomic timescales
+    atomic_implicit = opt["atomic_implicit"]
+                          .doc("With split_operator, treat atomic sources "
+                               "implicitly rather than explicitly")
+                          .withDefault<bool>(false);
+    if (atomic_implicit && !split_operator) {
+      throw BoutException("atomic_implicit requires split_operator = true");
+    }
+    if (atomic_implicit && charge_exchange_escape) {
+      // The redistributed CX neutrals are summed in the explicit part
+      throw BoutException("atomic_implicit can't be used with charge_exchange_escape");
+    }
+    atomic_precon = opt["atomic_precon"]
+                        .doc("Include cell-local atomic source Jacobians in "
+                             "the preconditioner")
+                        .withDefault<bool>(atomic_implicit);
+    atomic_jacobian_check = opt["atomic_jacobian_check"]
+                                .doc("Check one entry of the atomic preconditioner "
+                                     "Jacobian against a finite difference. For testing")
+                                .withDefault<bool>(false);
+
+    //////////////////////////////////////////
+    // Steady-state solver
+    // Pseudo-transient continuation (PTC), run before time integration
+    steady_state = opt["steady_state"]
+                       .doc("Solve for steady state with pseudo-transient "
+                            "continuation before time integration")
+                       .withDefault<bool>(false);
+    steady_dtau = opt["steady_dtau"]
+                      .doc("Initial pseudo-timestep (normalised)")
+                      .withDefault(10.0);
+    steady_dtau_max = opt["steady_dtau_max"]
+                          .doc("Maximum pseudo-timestep (normalised)")
+                          .withDefault(1e10);
+    steady_growth_max = opt["steady_growth_max"]
+                            .doc("Maximum factor by which the pseudo-timestep "
+                                 "can grow in one step")
+                            .withDefault(10.0);
+    steady_reject_factor = opt["steady_reject_factor"]
+                               .doc("Reject pseudo-timesteps which increase the "
+                                    "residual norm by more than this factor")
+                               .withDefault(1.0);
+    steady_maxiter = opt["steady_maxiter"]
+                         .doc("Maximum number of pseudo-timesteps")
+                         .withDefault(200);
+    steady_atol = opt["steady_atol"]
+                      .doc("Absolute tolerance on the residual norm")
+                      .withDefault(1e-10);
+    steady_rtol = opt["steady_rtol"]
+                      .doc("Tolerance on residual norm relative to initial")
+                      .withDefault(1e-8);
+    steady_krylov_dim = opt["steady_krylov_dim"]
+                            .doc("Maximum number of GMRES iterations per step")
+                            .withDefault(30);
+    steady_linear_rtol = opt["steady_linear_rtol"]
+                             .doc("Relative tolerance of the linear solve")
+                             .withDefault(1e-3);
+
+    //////////////////////////////////////////
+    // Adaptive grid
+    // Cells are redistributed along y at output times
+    adapt_grid = opt["adapt_grid"]
+                     .doc("Redistribute grid cells at output times to "
+                          "equidistribute gradients")
+                     .withDefault<bool>(false);
+    if (adapt_grid) {
+      adapt_every = opt["adapt_every"]
+                        .doc("Number of outputs between grid adaptations")
+                        .withDefault(1);
+      adapt_alpha = opt["adapt_alpha"]
+                        .doc("Weight of gradients in the monitor function. "
+                             "Zero gives uniform spacing")
+                        .withDefault(1.0);
+      adapt_smoothing = opt["adapt_smoothing"]
+                            .doc("Number of smoothing passes of the monitor "
+                                 "function")
+                            .withDefault(4);
+      adapt_min_fraction = opt["adapt_min_fraction"]
+                               .doc("Minimum cell size as a fraction of the "
+                                    "uniform cell size")
+                               .withDefault(0.1);
+
+      // Input profiles (area, sources, weights) are defined on the
+      // initial grid. Save them so that they can be remapped by position
+      // whenever the grid changes
+      ref_edges = globalCellEdges();
+      ref_J = gatherY(coord->J);
+      if (volume_source) {
+        ref_NeSource = gatherY((density_upstream > 0.0) ? NeSource0 : NeSource);
+        ref_PeSource = gatherY(PeSource);
+      }
+      ref_redist_weight = gatherY(redist_weight);
+      ref_dneut = gatherY(dneut);
+
+      dy_adapt = coord->dy;
+      SAVE_REPEAT(dy_adapt);
+      restart.add(dy_adapt, "dy_adapt");
+    }
+
+    // Starting profiles can be read from another run, which may have
+    // a different resolution or length
+    import_path = opt["import_path"]
+                      .doc("Directory containing files to start from, if not "
+                           "restarting. Empty to use the initial profiles")
+                      .withDefault<std::string>("");
+    import_prefix = opt["import_prefix"]
+                        .doc("Name of the files to start from, before the "
+                             "processor number: BOUT.restart or BOUT.dmp")
+                        .withDefault<std::string>("BOUT.restart");
+
+    return 0;
+  }
+
+  /*!
+   * Called after init, once restart files have been read.
+   * If steady_state is set then iterate to steady state here,
+   * so that the time solver starts from the converged solution.
+   */
+  int postInit(bool restarting) {
+    int result = PhysicsModel::postInit(restarting);
+    if (result != 0) {
+      return result;
+    }
+    if (adapt_grid && restarting && (min(dy_adapt, true) > 0.0)) {
+      // Evolving variables are already on the adapted grid
+      Coordinates *coord = mesh->getCoordinates();
+      std::vector<BoutReal> length = gatherY(dy_adapt * sqrt(coord->g_22));
+      std::vector<BoutReal> edges(length.size() + 1, 0.0);
+      for (std::size_t i = 0; i < length.size(); i++) {
+        edges[i + 1] = edges[i] + length[i];
+      }
+      setGrid(edges);
+    }
+    if (!restarting && !import_path.empty()) {
+      importRun();
+    }
+    if (steady_state) {
+      solveSteadyState();
+    }
     return 0;
   }
 
@@ -540,63 +933,121 @@ protected:
    */
   int rhs(BoutReal time) {
     // fprintf(stderr, "\rTime: %e", time);
+    rhs_timer.start();
+    countRhsCall(time);
 
     Coordinates *coord = mesh->getCoordinates();
 
-    mesh->communicate(Ne, NVi, P);
-
-    // Floor small values
+    // Floor small values. This is done before communicating,
+    // so that guard cells are also floored
+    countClamps(CLAMP_P, [&](const Ind3D &i) { return P[i] < 1e-10; });
+    countClamps(CLAMP_NE, [&](const Ind3D &i) { return Ne[i] < 1e-10; });
+    if (atomic) {
+      countClamps(CLAMP_NN, [&](const Ind3D &i) { return Nn[i] < 1e-10; });
+    }
     P = floor(P, 1e-10);
     Ne = floor(Ne, 1e-10);
-
-    Field3D Nelim = floor(Ne, 1e-5);
-
-    Vi = NVi / Ne;
-
-    Te = 0.5 * P / Ne; // Assuming Te = Ti
-
-    for (auto &i : Te.getRegion("RGN_NOBNDRY")) {
-      if (Te[i] > 10.)
-        Te[i] = 10.;
+    if (atomic) {
+      Nn = floor(Nn, 1e-10);
     }
-    
-    Field3D Nnlim;
-    Field3D Tn;
+
+    // All guard cell communication is done in a single exchange.
+    // Coefficients which depend on these fields are then calculated
+    // in the guard cells, rather than being communicated.
+    // The exchange is started here, and cells which don't need guard
+    // cell values are calculated while messages are in flight.
+    // Until the wait, the fields in the group must not be modified.
+    FieldGroup comms(Ne, NVi, P);
     if (atomic) {
-      // Includes atomic processes, neutral gas
-      mesh->communicate(Nn);
+      comms.add(Nn);
       if (evolve_nvn) {
-        mesh->communicate(NVn);
+        comms.add(NVn);
       }
       if (evolve_pn) {
-        mesh->communicate(Pn);
+        comms.add(Pn);
       }
-      Nn = floor(Nn, 1e-10);
-      Nnlim = floor(Nn, 1e-5);
+    }
+    comm_handle comms_handle = mesh->send(comms);
+    rhs_exchanges = 1;
+
+    // Scalars needed on all processors are summed along y in a single
+    // non-blocking collective, started once all are known and completed
+    // at the end of rhs. Each is only non-zero on one processor:
+    //  [0] Neutrals to be redistributed (target processor)
+    //  [1] Fast CX neutral particles (all processors, summed)
+    //  [2] Fast CX neutral energy (all processors, summed)
+    //  [3] Upstream density controller source (upstream processor)
+    BoutReal reduce_send[4] = {0.0, 0.0, 0.0, 0.0};
+    BoutReal reduce_recv[4];
+    MPI_Request reduce_request = MPI_REQUEST_NULL;
+    MPI_Comm ycomm = mesh->getYcomm(mesh->xstart);
+    const bool reduce_scalars =
+        rhs_explicit && (atomic || ((density_upstream > 0.0) && volume_source));
+
+    Field3D Nelim, Nnlim, Tn;
+    derivedQuantities(Nelim, Nnlim, Tn); // Guard cells not yet valid
+
+    // Range of cells whose atomic rates don't depend on guard cells.
+    // Rates use neighbouring cells, and the thermal force uses
+    // the gradient at neighbouring cells.
+    int jstart = mesh->ystart + 1, jend = mesh->yend - 1;
+    if (include_braginskii_rt) {
+      jstart++;
+      jend--;
+    }
+    if (jstart > jend) {
+      // No interior cells; calculate all cells after the wait
+      jstart = mesh->yend + 1;
+      jend = mesh->yend;
+    }
+    rhs_timer.lap(TIME_DERIVED);
 
-      if (evolve_nvn) {
-        Vn = NVn / Nnlim;
-      } else {
-        Vn = -vwall * sqrt(3.5 / Tnorm);
-        NVn = Nn * Vn;
+    if (atomic && rhs_atomic) {
+      TRACE("Atomic interior");
+
+      E = 0.0; // Energy transfer to neutrals
+      if (fimp > 0.0) {
+        Rzrad.allocate();
+      } // else Rzrad = 0.0 set in init()
+
+      // Only cells jstart - 1 to jend + 1 are needed, so guard cells
+      // which haven't yet been communicated don't affect the result
+      Field3D Nnlim2 = floor(Nn, 0.0);
+      if (include_braginskii_rt) {
+        gradT = Grad_par(Te);
       }
+      atomicRates(jstart, jend, Tn, Nnlim2);
+      rhs_timer.lap(TIME_ATOMIC);
+    }
+
+    mesh->wait(comms_handle);
+    rhs_timer.lap(TIME_COMMS);
 
+    // Recalculate now that guard cells have been communicated
+    derivedQuantities(Nelim, Nnlim, Tn);
+
+    // Te and Tn have been limited, so the limits are counted
+    // using the unlimited values
+    countClamps(CLAMP_TE, [&](const Ind3D &i) { return 0.5 * P[i] / Ne[i] > 10.; });
+    if (atomic) {
+      const BoutReal tn_min = tn_floor / Tnorm;
       if (evolve_pn) {
-        Tn = Pn / Nnlim;
-        // Tn = floor(Tn, 0.025/Tnorm); // Minimum tn_floor
-        Tn = floor(Tn, 1e-12);
-      } else {
-          if (tn_3ev) {
-            Tn = 3 / Tnorm; // Weak CX coupling, Tn=3eV (Franck-Condon, SOLKiT assumption). Do not use  [MK]
-          } else {
-            Tn = Te; // Strong CX coupling
-          }
-        Pn = Tn * floor(Nn, 0.0);
-        Tn = floor(Tn, tn_floor / Tnorm); // Minimum of tn_floor
+        countClamps(CLAMP_TN, [&](const Ind3D &i) { return Tn[i] < tn_min; });
+      } else if (!tn_3ev) {
+        countClamps(CLAMP_TN, [&](const Ind3D &i) { return Te[i] < tn_min; });
       }
     }
+    rhs_timer.lap(TIME_DERIVED);
+
+    bool recalculate_coefficients = update_coefficients;
+    if (freeze_coefficients && recalculate_coefficients) {
+      // Within an implicit step all calls are at the same time, and
+      // the state changes little between Newton iterations
+      recalculate_coefficients = (time != coefficient_time);
+      coefficient_time = time;
+    }
 
-    if (update_coefficients) {
+    if (recalculate_coefficients) {
       // Update diffusion coefficients
       TRACE("Update coefficients");
 
@@ -619,13 +1070,26 @@ protected:
           
           // Spitzer-Harm heat flux
           Te.applyBoundary("neumann"); // Note: We haven't yet applied boundaries
-          Field3D q_SH = kappa_epar * Grad_par(Te);
+          Field3D gradTe = Grad_par(Te);
+
+          // Values of kappa on cell boundaries are needed for fluxes.
+          // Calculate the gradient in guard cells with central differences
+          // so that kappa_epar doesn't need to be communicated
+          for (int i = 0; i < mesh->LocalNx; i++)
+            for (int j = 1; j < mesh->LocalNy - 1; j++) {
+              if ((j >= mesh->ystart) && (j <= mesh->yend)) {
+                continue;
+              }
+              for (int k = 0; k < mesh->LocalNz; k++) {
+                gradTe(i, j, k) = (Te(i, j + 1, k) - Te(i, j - 1, k)) /
+                                  (2. * coord->dy(i, j) * sqrt(coord->g_22(i, j)));
+              }
+            }
+
+          Field3D q_SH = kappa_epar * gradTe;
           Field3D q_fl = kappa_limit_alpha * Nelim * Te * sqrt(mi_me * Te);
           
           kappa_epar = kappa_epar / (1. + abs(q_SH / q_fl));
-          
-          // Values of kappa on cell boundaries are needed for fluxes
-          mesh->communicate(kappa_epar);
         }
         
         kappa_epar.applyBoundary("neumann");
@@ -635,37 +1099,44 @@ protected:
       if (atomic) {
         // Neutral diffusion rate
 
+        // Cells are independent, so can be calculated in parallel
+        Dn.allocate();
+        kappa_n.allocate();
+        BOUT_OMP(parallel for collapse(3) schedule(runtime))
         for (int i = 0; i < mesh->LocalNx; i++)
           for (int j = 0; j < mesh->LocalNy; j++)
             for (int k = 0; k < mesh->LocalNz; k++) {
               // Charge exchange frequency, normalised to ion cyclotron
               // frequency
         
+              // Logarithms shared by the rates
+              const LogState logs(Te(i, j, k) * Tnorm, Ne(i, j, k) * Nnorm);
+
               // Initialise outside of the if statement
               // Cross-sections normalised as sigma*Nnorm*rho_s0 == [m2][m-3][m]
               BoutReal sigma_cx;
               
-              if (cx_model == "solkit") {
+              if (cx_solkit) {
                 
                 sigma_cx = Nelim(i, j, k) * (3e-19 * Nnorm * rho_s0) * Vi(i, j, k); // Dimensionless.
                           
               } else {
                 
                 sigma_cx = Nelim(i, j, k) * Nnorm *
-                          hydrogen.chargeExchange(Te(i, j, k) * Tnorm) /
+                          hydrogen.chargeExchange(logs) /
                           Omega_ci;
               }
 
               
               // Ionisation frequency
               BoutReal sigma_iz;
-              if (iz_rate == "solkit") {              
+              if (iz_solkit) {              
                 sigma_iz = Nelim(i, j, k) * Nnorm *
-                                    hydrogen.ionisation(Ne(i,j,k) * Nnorm, Te(i, j, k) * Tnorm) /
+                                    hydrogen.ionisation(logs) /
                                     Omega_ci;
               } else {
                 sigma_iz = Nelim(i, j, k) * Nnorm *
-                                    hydrogen.ionisation_old(Te(i, j, k) * Tnorm) /
+                                    hydrogen.ionisation_old(logs) /
                                     Omega_ci;
               }
 
@@ -713,7 +1184,7 @@ protected:
                   
                 } else {
             
-                  if (dn_model=="solkit") {
+                  if (dn_solkit) {
                     
                     BoutReal vth_3ev = sqrt(2 * 3 * 1.60217662E-19 / (AA * 1.6726219e-27)) / Cs0; // sqrt(2Te[eV] * q_e [J/eV] / (2 * mass_p [kg])) = Vth [m/s]. Normalised by  Cs0[m/s]
                     
@@ -730,12 +1201,14 @@ protected:
               }
             }
 
+        // Calculated in all cells, so only physical boundaries need setting
         kappa_n.applyBoundary("Neumann");
         Dn.applyBoundary("dirichlet_o2");
-        mesh->communicate(kappa_n, Dn);
       }
     }
 
+    rhs_timer.lap(TIME_COEFFICIENTS);
+
     // Set sheath boundary condition on flow
 
     TRACE("Sheath");
@@ -989,6 +1462,8 @@ protected:
         density_error_last = error;
         density_error_lasttime = time;
 
+        reduce_send[3] = source; // Sent to all processors at the end of rhs
+
         if (!volume_source) {
           // Convert source into a flow velocity
           // through the boundary, based on a zero-gradient boundary on the
@@ -1024,521 +1499,30 @@ protected:
         }
       }
 
-      if (volume_source) {
-        if ((source < 0.0) && density_source_positive) {
-          source = 0.0; // Don't remove particles
-        }
-
-        // Broadcast the value of source from processor 0
-        MPI_Bcast(&source, 1, MPI_DOUBLE, 0, BoutComm::get());
-        ASSERT2(std::isfinite(source));
-
-        // Scale NeSource
-        NeSource = source * NeSource0;
-      }
+      // If volume_source, NeSource is set at the end of rhs
     }
+    rhs_timer.lap(TIME_BOUNDARY);
 
-    if (atomic && rhs_explicit) {
+    if (atomic && rhs_atomic) {
       // Atomic physics
       TRACE("Atomic");
 
       // Lower floor on Nn for atomic rates
       Field3D Nnlim2 = floor(Nn, 0.0);
-      
-      if (fimp > 0.0) {
-        // Impurity radiation
-
-        if (impurity_adas) {
-          Rzrad.allocate();
-          for (auto &i : Rzrad.getRegion("RGN_NOY")) {
-            // Calculate cell centre (C), left (L) and right (R) values
-
-            BoutReal Te_C = Te[i],
-              Te_L = 0.5 * (Te[i.ym()] + Te[i]),
-              Te_R = 0.5 * (Te[i] + Te[i.yp()]);
-            BoutReal Ne_C = Ne[i],
-              Ne_L = 0.5 * (Ne[i.ym()] + Ne[i]),
-              Ne_R = 0.5 * (Ne[i] + Ne[i.yp()]);
-            BoutReal Nn_C = Nnlim2[i],
-              Nn_L = 0.5 * (Nnlim2[i.ym()] + Nnlim2[i]),
-              Nn_R = 0.5 * (Nnlim2[i] + Nnlim2[i.yp()]);
-            
-            BoutReal Rz_L = computeRadiatedPower(*impurity,
-                                                 Te_L * Tnorm,        // electron temperature [eV]
-                                                 Ne_L * Nnorm,        // electron density [m^-3]
-                                                 fimp * Ne_L * Nnorm, // impurity density [m^-3]
-                                                 Nn_L * Nnorm);       // Neutral density [m^-3]
-
-            BoutReal Rz_C = computeRadiatedPower(*impurity,
-                                                 Te_C * Tnorm,        // electron temperature [eV]
-                                                 Ne_C * Nnorm,        // electron density [m^-3]
-                                                 fimp * Ne_C * Nnorm, // impurity density [m^-3]
-                                                 Nn_C * Nnorm);       // Neutral density [m^-3]
-
-            BoutReal Rz_R = computeRadiatedPower(*impurity,
-                                                 Te_R * Tnorm,        // electron temperature [eV]
-                                                 Ne_R * Nnorm,        // electron density [m^-3]
-                                                 fimp * Ne_R * Nnorm, // impurity density [m^-3]
-                                                 Nn_R * Nnorm);       // Neutral density [m^-3]
-
-
-            // Jacobian (Cross-sectional area)
-            BoutReal J_C = coord->J[i],
-              J_L = 0.5 * (coord->J[i.ym()] + coord->J[i]),
-              J_R = 0.5 * (coord->J[i] + coord->J[i.yp()]);
-
-            // Simpson's rule, calculate average over cell
-            Rzrad[i] = (J_L * Rz_L +
-                        4. * J_C * Rz_C +
-                        J_R * Rz_R) / (6. * J_C);
-          }
-        } else {
-          Rzrad = rad->power(Te * Tnorm, Ne * Nnorm,
-                             Ne * (Nnorm * fimp)); // J / m^3 / s
-        }
-        Rzrad /= SI::qe * Tnorm * Nnorm * Omega_ci; // Normalise
-      } // else Rzrad = 0.0 set in init()
-
-      E = 0.0; // Energy transfer to neutrals
-
-      for (int i = 0; i < mesh->LocalNx; i++)
-        for (int j = mesh->ystart; j <= mesh->yend; j++)
-          for (int k = 0; k < mesh->LocalNz; k++) {
-
-            // Integrate rates over each cell using Simpson's rule
-            // Calculate cell centre (C), left (L) and right (R) values
-
-            BoutReal Te_C = Te(i, j, k),
-                     Te_L = 0.5 * (Te(i, j - 1, k) + Te(i, j, k)),
-                     Te_R = 0.5 * (Te(i, j, k) + Te(i, j + 1, k));
-            BoutReal Ne_C = Ne(i, j, k),
-                     Ne_L = 0.5 * (Ne(i, j - 1, k) + Ne(i, j, k)),
-                     Ne_R = 0.5 * (Ne(i, j, k) + Ne(i, j + 1, k));
-            BoutReal Vi_C = Vi(i, j, k),
-                     Vi_L = 0.5 * (Vi(i, j - 1, k) + Vi(i, j, k)),
-                     Vi_R = 0.5 * (Vi(i, j, k) + Vi(i, j + 1, k));
-            BoutReal Tn_C = Tn(i, j, k),
-                     Tn_L = 0.5 * (Tn(i, j - 1, k) + Tn(i, j, k)),
-                     Tn_R = 0.5 * (Tn(i, j, k) + Tn(i, j + 1, k));
-            BoutReal Nn_C = Nnlim2(i, j, k),
-                     Nn_L = 0.5 * (Nnlim2(i, j - 1, k) + Nnlim2(i, j, k)),
-                     Nn_R = 0.5 * (Nnlim2(i, j, k) + Nnlim2(i, j + 1, k));
-            BoutReal Vn_C = Vn(i, j, k),
-                     Vn_L = 0.5 * (Vn(i, j - 1, k) + Vn(i, j, k)),
-                     Vn_R = 0.5 * (Vn(i, j, k) + Vn(i, j + 1, k));
-
-            // Jacobian (Cross-sectional area)
-            BoutReal J_C = coord->J(i, j),
-                     J_L = 0.5 * (coord->J(i, j - 1) + coord->J(i, j)),
-                     J_R = 0.5 * (coord->J(i, j) + coord->J(i, j + 1));
-
-            ///////////////////////////////////////
-            // Charge exchange
-      
-      // These need initialisation outside of the if statements
-      BoutReal R_cx_L, R_cx_C, R_cx_R;
-      
-            if (charge_exchange) {
-        
-              // SOLKIT MODEL (MK 12/05/2022)
-              // CONSTANT CROSS-SECTION 3E-19m2, COLD ION/NEUTRAL AND STATIC NEUTRAL ASSUMPTION
-              if (cx_model == "solkit") {
-                R_cx_L = Ne_L * Nn_L * (3e-19 * Nnorm * rho_s0) * Vi_L;
-
-                R_cx_C = Ne_C * Nn_C * (3e-19 * Nnorm * rho_s0) * Vi_C;
-
-                R_cx_R = Ne_R * Nn_R * (3e-19 * Nnorm * rho_s0) * Vi_R;
-
-              } else {
-              // ORIGINAL MODEL 
-                R_cx_L = Ne_L * Nn_L *
-                        hydrogen.chargeExchange(Te_L * Tnorm) *
-                        (Nnorm / Omega_ci);
-                R_cx_C = Ne_C * Nn_C *
-                        hydrogen.chargeExchange(Te_C * Tnorm) *
-                        (Nnorm / Omega_ci);
-                R_cx_R = Ne_R * Nn_R *
-                        hydrogen.chargeExchange(Te_R * Tnorm) *
-                        (Nnorm / Omega_ci);
-              }
-      
-              // Ecx is energy transferred to neutrals
-              // Set to 0 if neutral temperature not evolved [MK]
-              if (evolve_pn) {
-                Ecx(i, j, k) = (3. / 2) *
-                               (J_L * (Te_L - Tn_L) * R_cx_L +
-                                4. * J_C * (Te_C - Tn_C) * R_cx_C +
-                                J_R * (Te_R - Tn_R) * R_cx_R) /
-                               (6. * J_C);
-              }
-
-              // Fcx is friction between plasma and neutrals
-              Fcx(i, j, k) = (J_L * (Vi_L - Vn_L) * R_cx_L +
-                              4. * J_C * (Vi_C - Vn_C) * R_cx_C +
-                              J_R * (Vi_R - Vn_R) * R_cx_R) /
-                             (6. * J_C);
-
-              // Dcx is a redistribution of fast neutrals due to charge exchange
-              // Acts as a sink of plasma density
-              Dcx(i, j, k) = (J_L * R_cx_L + 4. * J_C * R_cx_C + J_R * R_cx_R) /
-                             (6. * J_C);
-
-              // Energy lost from the plasma
-              // This gives the temperature of the CX neutrals when
-              // divided by Dcx
-              Dcx_T(i, j, k) = (J_L * Te_L * R_cx_L + 4. * J_C * Te_C * R_cx_C +
-                                J_R * Te_R * R_cx_R) /
-                               (6. * J_C);
-            }
-            
-            if (read_s == false) {
-                ///////////////////////////////////////
-                // Recombination
-
-                if (recombination) {
-                  BoutReal R_rc_L =
-                      hydrogen.recombination(Ne_L * Nnorm, Te_L * Tnorm) *
-                      SQ(Ne_L) * Nnorm / Omega_ci;
-                  BoutReal R_rc_C =
-                      hydrogen.recombination(Ne_C * Nnorm, Te_C * Tnorm) *
-                      SQ(Ne_C) * Nnorm / Omega_ci;
-                  BoutReal R_rc_R =
-                      hydrogen.recombination(Ne_R * Nnorm, Te_R * Tnorm) *
-                      SQ(Ne_R) * Nnorm / Omega_ci;
-
-                  // Rrec is radiated energy, Erec is energy transferred to neutrals
-                  // Factor of 1.09 so that recombination becomes an energy source
-                  // at 5.25eV
-                  Rrec(i, j, k) =
-                      (J_L * (1.09 * Te_L - 13.6 / Tnorm) * R_rc_L +
-                       4. * J_C * (1.09 * Te_C - 13.6 / Tnorm) * R_rc_C +
-                       J_R * (1.09 * Te_R - 13.6 / Tnorm) * R_rc_R) /
-                      (6. * J_C);
-                  
-                  if (include_erec) {
-                    Erec(i, j, k) = (3. / 2) *
-                                    (J_L * Te_L * R_rc_L + 4. * J_C * Te_C * R_rc_C +
-                                     J_R * Te_R * R_rc_R) /
-                                    (6. * J_C);
-                  }
-
-                  Frec(i, j, k) = (J_L * Vi_L * R_rc_L + 4. * J_C * Vi_C * R_rc_C +
-                                   J_R * Vi_R * R_rc_R) /
-                                  (6. * J_C);
-
-                  Srec(i, j, k) =
-                      (J_L * R_rc_L + 4. * J_C * R_rc_C + J_R * R_rc_R) /
-                      (6. * J_C);
-                }
-
-                ///////////////////////////////////////
-                // Ionisation
-
-                if (ionisation) {
-                  BoutReal R_iz_L, R_iz_C, R_iz_R;
-                
-                  if (iz_rate == "solkit") {
-                    R_iz_L = Ne_L * Nn_L *
-                                      hydrogen.ionisation(Ne_L * Nnorm, Te_L * Tnorm) * Nnorm /
-                                      Omega_ci;
-                    R_iz_C = Ne_C * Nn_C *
-                                      hydrogen.ionisation(Ne_C * Nnorm, Te_C * Tnorm) * Nnorm /
-                                      Omega_ci;
-                    R_iz_R = Ne_R * Nn_R *
-                                      hydrogen.ionisation(Ne_R * Nnorm, Te_R * Tnorm) * Nnorm /
-                                      Omega_ci;
-                  } else {
-                    R_iz_L = Ne_L * Nn_L *
-                                    hydrogen.ionisation_old(Te_L * Tnorm) * Nnorm /
-                                    Omega_ci;
-                    R_iz_C = Ne_C * Nn_C *
-                                      hydrogen.ionisation_old(Te_C * Tnorm) * Nnorm /
-                                      Omega_ci;
-                    R_iz_R = Ne_R * Nn_R *
-                                      hydrogen.ionisation_old(Te_R * Tnorm) * Nnorm /
-                                      Omega_ci;
-                  }
-
-                  Riz(i, j, k) =
-                      (Eionize / Tnorm) *
-                      ( // Energy loss per ionisation
-                          J_L * R_iz_L + 4. * J_C * R_iz_C + J_R * R_iz_R) /
-                      (6. * J_C);
-                      
-                  if (include_eiz) {
-                    Eiz(i, j, k) =
-                        -(3. / 2) *
-                        ( // Energy from neutral atom temperature
-                            J_L * Tn_L * R_iz_L + 4. * J_C * Tn_C * R_iz_C +
-                            J_R * Tn_R * R_iz_R) /
-                        (6. * J_C);
-                  }
-
-                  // Friction due to ionisation
-                  Fiz(i, j, k) = -(J_L * Vn_L * R_iz_L + 4. * J_C * Vn_C * R_iz_C +
-                                   J_R * Vn_R * R_iz_R) /
-                                 (6. * J_C);
-
-                  // Plasma sink due to ionisation (negative)
-                  Siz(i, j, k) =
-                      -(J_L * R_iz_L + 4. * J_C * R_iz_C + J_R * R_iz_R) /
-                      (6. * J_C);
-                
-        
-                  if (atomic_debug) {
-                    // Rate diagnostics
-                    // Calculate field Siz_compare which is saved but doesn't go into other calculations
-                    R_iz_L = Ne_L * Nn_L *
-                                    hydrogen.ionisation_old(Te_L * Tnorm) * Nnorm /
-                                    Omega_ci;
-                    R_iz_C = Ne_C * Nn_C *
-                                      hydrogen.ionisation_old(Te_C * Tnorm) * Nnorm /
-                                      Omega_ci;
-                    R_iz_R = Ne_R * Nn_R *
-                                      hydrogen.ionisation_old(Te_R * Tnorm) * Nnorm /
-                                      Omega_ci;
-
-                    Siz_compare(i, j, k) =
-                    -(J_L * R_iz_L + 4. * J_C * R_iz_C + J_R * R_iz_R) /
-                    (6. * J_C);
-                  }
-                }
-              }
-
-            if (elastic_scattering) {
-              /////////////////////////////////////////////////////////
-              // Ion-neutral elastic scattering
-              //
-              // Post "A Review of Recent Developments in Atomic Processes for
-              // Divertors and Edge Plasmas" PSI review paper
-              //       https://arxiv.org/pdf/plasm-ph/9506003.pdf
-              // Relative velocity of two particles in a gas
-              // is sqrt(8kT/pi mu) where mu = m_A*m_B/(m_A+m_B)
-              // here ions and neutrals have same mass,
-              // and the ion temperature is used
-
-              BoutReal a0 = 3e-19; // Effective cross-section [m^2]
-
-              // Rates (normalised)
-              BoutReal R_el_L = a0 * Ne_L * Nn_L * Cs0 *
-                                sqrt((16. / PI) * Te_L) * Nnorm / Omega_ci;
-              BoutReal R_el_C = a0 * Ne_C * Nn_C * Cs0 *
-                                sqrt((16. / PI) * Te_C) * Nnorm / Omega_ci;
-              BoutReal R_el_R = a0 * Ne_R * Nn_R * Cs0 *
-                                sqrt((16. / PI) * Te_R) * Nnorm / Omega_ci;
-
-              // Elastic transfer of momentum
-              Fel(i, j, k) = (J_L * (Vi_L - Vn_L) * R_el_L +
-                              4. * J_C * (Vi_C - Vn_C) * R_el_C +
-                              J_R * (Vi_R - Vn_R) * R_el_R) /
-                             (6. * J_C);
-
-              // Elastic transfer of thermal energy
-              Eel(i, j, k) = (3. / 2) *
-                             (J_L * (Te_L - Tn_L) * R_el_L +
-                              4. * J_C * (Te_C - Tn_C) * R_el_C +
-                              J_R * (Te_R - Tn_R) * R_el_R) /
-                             (6. * J_C);
-            }
-            
-            if (include_braginskii_rt) {
-              /////////////////////////////////////////////////////////
-              // Braginskii thermal electron-ion friction as plasma energy sink
-              gradT = Grad_par(Te);
-              
-              BoutReal gradT_C = gradT(i, j, k);
-              BoutReal gradT_L = 0.5 * (gradT(i, j - 1, k) + gradT(i, j, k));
-              BoutReal gradT_R = 0.5 * (gradT(i, j, k) + gradT(i, j + 1, k));
-                       
-              BoutReal E_rt_L = Vi_L * 0.71 * Ne_L * gradT_L;
-              BoutReal E_rt_C = Vi_C * 0.71 * Ne_C * gradT_C;
-              BoutReal E_rt_R = Vi_R * 0.71 * Ne_R * gradT_R;
-              
-              
-              Ert(i, j, k) = (J_L * E_rt_L + 4. * J_C * E_rt_C + J_R * E_rt_R) / (6. * J_C);
-              // Hopelessly trying to prevent issues in guard cells..
-              for (RangeIterator r = mesh->iterateBndryUpperY(); !r.isDone(); r++) {
-                int jz = 0;
-                Ert(r.ind, mesh->yend-1, jz) = Ert(r.ind, mesh->yend-2, jz);
-                Ert(r.ind, mesh->yend, jz) = Ert(r.ind, mesh->yend-2, jz);
-              }
-              // Ert(i, mesh->yend, k) = Ert(i, mesh->yend-1, k);
-              // Ert(i, mesh->ystart, k) = Ert(i, mesh->yend-1, k);
-              
-              // Ert = -Vi * 0.71 * Ne * Grad_par(Te);
-              
-            }
-            
-            if (read_r == false) {
-              if (excitation) {
-                /////////////////////////////////////////////////////////
-                // Electron-neutral excitation
-                // Note: Rates need checking
-                // Currently assuming that quantity calculated is in [eV m^3/s]
-                // MK modified this to calculate net excitation rate from AMJUEL 
-                // effective excitation energy rate minus base ionisation energy cost 13.6eV * fION  
-                // where fION is the Sawada ionisation rate in the low density (coronal) limit of 1e8 cm-3
-                // this is used because the coronal limit won't include any excited state effects which are accounted 
-                // for in the excitation energy rate already. Note functions are in m-3 hence 1e8 * 1e6
-                BoutReal R_ex_L, R_ex_C, R_ex_R;
-
-                if (ex_rate=="solkit") {
-                  R_ex_L = Ne_L * Nn_L *
-                                    (hydrogen.excitation(Ne_L * Nnorm, Te_L * Tnorm) - hydrogen.ionisation(1e8*1e6, Te_L * Tnorm) * 13.6) * Nnorm /
-                                    Omega_ci / Tnorm;
-                  R_ex_C = Ne_C * Nn_C *
-                                    (hydrogen.excitation(Ne_C * Nnorm, Te_C * Tnorm) - hydrogen.ionisation(1e8*1e6, Te_C * Tnorm) * 13.6) * Nnorm /
-                                    Omega_ci / Tnorm;
-                  R_ex_R = Ne_R * Nn_R *
-                                    (hydrogen.excitation(Ne_R * Nnorm, Te_R * Tnorm) - hydrogen.ionisation(1e8*1e6, Te_R * Tnorm) * 13.6) * Nnorm /
-                                    Omega_ci / Tnorm;
-
-                  Rex(i, j, k) = (J_L * R_ex_L + 4. * J_C * R_ex_C + J_R * R_ex_R) /
-                                 (6. * J_C);
-                }
-                
-                if (ex_rate=="population") {
-                  // Calculate excitation rate based on Yulin Zhou's approach (Zhou 2022)
-                  // Take AMJUEL rates H.12 2.1.5b through to 2.1.5e. These give you populations of excited states
-                  // These are in the format Nn (excited state) / Nn (ground state) and provide up to 6th state
-                  // Then use einstein coefficients from Yacora to calculate the radiation. See the paper for details.
-                  
-                  // Energy gap between different levels in H atom in units of [eV]
-                  BoutReal E_21=10.2,E_31=12.1,E_41=12.8,E_51=13.05,E_61=13.22;
-                  
-                  // Einstein coefficients in units of [s-1]
-                  // http://astronomy.nmsu.edu/cwc/CWC/545/13-AtomsHydrogenic.pdf
-                  // NOTE THAT A21 IS FROM YULIN'S SD1D CODE BUT SEEMS NOT CORRECT
-                  BoutReal A21=1.6986e+09,A31=5.5751e7,A41=1.2785e7,A51=4.1250e6,A61=1.6440e6;
-                  
-                  BoutReal R2_L = Nn_L * hydrogen.Channel_H_2_amjuel(Te_L * Tnorm, Ne_L * Nnorm)*A21*E_21 / Omega_ci / Tnorm;
-                  BoutReal R3_L = Nn_L * hydrogen.Channel_H_3_amjuel(Te_L * Tnorm, Ne_L * Nnorm)*A31*E_31 / Omega_ci / Tnorm;
-                  BoutReal R4_L = Nn_L * hydrogen.Channel_H_4_amjuel(Te_L * Tnorm, Ne_L * Nnorm)*A41*E_41 / Omega_ci / Tnorm;
-                  BoutReal R5_L = Nn_L * hydrogen.Channel_H_5_amjuel(Te_L * Tnorm, Ne_L * Nnorm)*A51*E_51 / Omega_ci / Tnorm;
-                  BoutReal R6_L = Nn_L * hydrogen.Channel_H_6_amjuel(Te_L * Tnorm, Ne_L * Nnorm)*A61*E_61 / Omega_ci / Tnorm;
-                  R_ex_L = R2_L + R3_L + R4_L + R5_L + R6_L;
-                  
-                  BoutReal R2_C = Nn_C * hydrogen.Channel_H_2_amjuel(Te_C * Tnorm, Ne_C * Nnorm)*A21*E_21 / Omega_ci / Tnorm;
-                  BoutReal R3_C = Nn_C * hydrogen.Channel_H_3_amjuel(Te_C * Tnorm, Ne_C * Nnorm)*A31*E_31 / Omega_ci / Tnorm;
-                  BoutReal R4_C = Nn_C * hydrogen.Channel_H_4_amjuel(Te_C * Tnorm, Ne_C * Nnorm)*A41*E_41 / Omega_ci / Tnorm;
-                  BoutReal R5_C = Nn_C * hydrogen.Channel_H_5_amjuel(Te_C * Tnorm, Ne_C * Nnorm)*A51*E_51 / Omega_ci / Tnorm;
-                  BoutReal R6_C = Nn_C * hydrogen.Channel_H_6_amjuel(Te_C * Tnorm, Ne_C * Nnorm)*A61*E_61 / Omega_ci / Tnorm;
-                  R_ex_C = R2_C + R3_C + R4_C + R5_C + R6_C;
-                  
-                  BoutReal R2_R = Nn_R * hydrogen.Channel_H_2_amjuel(Te_R * Tnorm, Ne_R * Nnorm)*A21*E_21 / Omega_ci / Tnorm;
-                  BoutReal R3_R = Nn_R * hydrogen.Channel_H_3_amjuel(Te_R * Tnorm, Ne_R * Nnorm)*A31*E_31 / Omega_ci / Tnorm;
-                  BoutReal R4_R = Nn_R * hydrogen.Channel_H_4_amjuel(Te_R * Tnorm, Ne_R * Nnorm)*A41*E_41 / Omega_ci / Tnorm;
-                  BoutReal R5_R = Nn_R * hydrogen.Channel_H_5_amjuel(Te_R * Tnorm, Ne_R * Nnorm)*A51*E_51 / Omega_ci / Tnorm;
-                  BoutReal R6_R = Nn_R * hydrogen.Channel_H_6_amjuel(Te_R * Tnorm, Ne_R * Nnorm)*A61*E_61 / Omega_ci / Tnorm;
-                  R_ex_R = R2_R + R3_R + R4_R + R5_R + R6_R;
-                  
-                  Rex(i, j, k) = (J_L * R_ex_L + 4. * J_C * R_ex_C + J_R * R_ex_R) /
-                                 (6. * J_C);
-                                 
-                if (atomic_debug) {							 
-                  // Calculate Rex the SD1D default way (HYDHEL H.2 2.1.5)
-                  R_ex_L = Ne_L * Nn_L *
-                                    hydrogen.excitation_old(Te_L * Tnorm) * Nnorm /
-                                    Omega_ci / Tnorm;
-                  R_ex_C = Ne_C * Nn_C *
-                                    hydrogen.excitation_old(Te_C * Tnorm) * Nnorm /
-                                    Omega_ci / Tnorm;
-                  R_ex_R = Ne_R * Nn_R *
-                                    hydrogen.excitation_old(Te_R * Tnorm) * Nnorm /
-                                    Omega_ci / Tnorm;
-                  
-                
-                  Rex_compare(i, j, k) = (J_L * R_ex_L + 4. * J_C * R_ex_C + J_R * R_ex_R) /
-                                 (6. * J_C);
-                }
-                } else {
-                  // Calculate the SD1D default way
-                  R_ex_L = Ne_L * Nn_L *
-                                    hydrogen.excitation_old(Te_L * Tnorm) * Nnorm /
-                                    Omega_ci / Tnorm;
-                  R_ex_C = Ne_C * Nn_C *
-                                    hydrogen.excitation_old(Te_C * Tnorm) * Nnorm /
-                                    Omega_ci / Tnorm;
-                  R_ex_R = Ne_R * Nn_R *
-                                    hydrogen.excitation_old(Te_R * Tnorm) * Nnorm /
-                                    Omega_ci / Tnorm;
-                                    
-                  Rex(i, j, k) = (J_L * R_ex_L + 4. * J_C * R_ex_C + J_R * R_ex_R) /
-                                 (6. * J_C);
-                }
-              }
-            }
-            
-            
-            // Total energy lost from system
-            // Compute only if we're not reading it from file [MK]
-            if (read_r) {
-              Rzrad(i, j, k) = 0;
-              Rrec(i, j, k) = 0;
-              Riz(i, j, k) = 0;
-              Rex(i, j, k) = 0;
-            } else {
-              R(i, j, k) = (Rzrad(i, j, k)  // Radiated power from impurities
-                           + Rrec(i, j, k) // Recombination
-                           + Riz(i, j, k)  // Ionisation
-                           + Rex(i, j, k)) * e_mod; // Excitation
-            }
-            
-            // Total energy transferred to neutrals
-            E(i, j, k) = (Ecx(i, j, k)    // Charge exchange
-                         + Erec(i, j, k) // Recombination
-                         + Eiz(i, j, k)  // ionisation
-                         + Eel(i, j, k)  // Elastic collisions
-                         + Ert(i, j, k)) * e_mod; // Braginskii RT [MK]
-            if (read_f) {
-                         // F is set to the imported value and others are zeroed [MK]
-                         F(i, j, k) = F_sk(i, j, k);
-                         Fiz(i, j, k) = 0;
-                         Fcx(i, j, k) = 0;
-                         Fel(i, j, k) = 0;
-                         Frec_sk(i, j, k) = 0;
-                         Fcx_exc(i, j, k) = 0;
-            } else {
-              // Total friction
-              F(i, j, k) =   (Frec(i, j, k)   // Recombination
-                           + Fiz(i, j, k)  // Ionisation
-                           + Fcx(i, j, k)  // Charge exchange
-                           + Fel(i, j, k)
-                           + Frec_sk(i, j, k)
-                           + Fcx_exc(i, j, k))*f_mod; // Elastic collisions
-            }
+      if (include_braginskii_rt) {
+        gradT = Grad_par(Te);
+      }
 
-            // Total sink of plasma, source of neutrals
-            // Compute only if we're not reading it from file [MK]
-            if (read_s) {
-              Srec(i, j, k) = 0;
-              Siz(i, j, k) = 0;
-            } else {
-              S(i, j, k) = (Srec(i, j, k) + Siz(i, j, k))*s_mod;
-            }
-            
-            
-            // For matching SOL-KiT thesis version, I doubled the conductivity, doubled heat input,
-            // doubled radiation and got rid of ion energy terms. Hopefully this is the same 
-            // as SOLKiT by having double power in, double out to match the double pressure we have from 
-            // having a plasma equation. [MK]
-            
-            // E(i, j, k) = E(i, j, k) * e_mod;
-            // R(i, j, k) = R(i, j, k) * e_mod; // Scale by energy mod
-            // F(i, j, k) = F(i, j, k) * f_mod; // Scale by friction mod
-            // S(i, j, k) = S(i, j, k) * s_mod; // Scale by source mod
-            
-            
-            ASSERT3(finite(R(i, j, k)));
-            ASSERT3(finite(E(i, j, k)));
-            ASSERT3(finite(F(i, j, k)));
-            ASSERT3(finite(S(i, j, k)));
-          }
+      // Cells jstart to jend were calculated before the guard cell exchange
+      // completed
+      atomicRates(mesh->ystart, jstart - 1, Tn, Nnlim2);
+      atomicRates(jend + 1, mesh->yend, Tn, Nnlim2);
 
       if (!evolve_nvn && neutral_f_pn) {
         // Not evolving neutral momentum
         F = Grad_par(Pn);
       }
+      rhs_timer.lap(TIME_ATOMIC);
     }
 
     ///////////////////////////////////////////////////
@@ -1555,13 +1539,8 @@ protected:
         Field3D a = sqrt(gamma_sound * 2. * Te); // Local sound speed
         ddt(Ne) = -FV::Div_par(Ne, Vi, a, bndry_flux_fix); // Mass flow
 
-        if (atomic) {
-          ddt(Ne) -= S; // Sink to recombination
-        }
-
-        if (volume_source) {
-          ddt(Ne) += NeSource; // External volume source
-        }
+        // External volume source NeSource added at the end of rhs,
+        // since it may depend on the density controller
 
       } else {
         ddt(Ne) = 0.0;
@@ -1582,6 +1561,11 @@ protected:
           ddt(Ne) += ADpar * AddedDissipation(1.0, P, Ne, true);
         }
       }
+
+      if (atomic && rhs_atomic) {
+        ddt(Ne) -= S; // Sink to recombination
+      }
+      rhs_timer.lap(TIME_DDT_NE);
     }
 
     {
@@ -1593,16 +1577,16 @@ protected:
         Field3D a = sqrt(gamma_sound * 2. * Te); // Local sound speed
         ddt(NVi) = -FV::Div_par(NVi, Vi, a, bndry_flux_fix) // Momentum flow
                    - Grad_par(P);
-
-        if (atomic) {
-          // Friction with neutrals
-          TRACE("ddt(NVi) -= F");
-          ddt(NVi) -= F;
-        }
       } else {
         ddt(NVi) = 0.0;
       }
 
+      if (atomic && rhs_atomic) {
+        // Friction with neutrals
+        TRACE("ddt(NVi) -= F");
+        ddt(NVi) -= F;
+      }
+
       if (rhs_implicit) {
         if (viscos > 0.) {
           ddt(NVi) += viscos * Div_par_diffusion_index(Vi);
@@ -1636,6 +1620,8 @@ protected:
       }
     }
 
+    rhs_timer.lap(TIME_DDT_NVI);
+
     {
       /// Pressure
 
@@ -1649,13 +1635,6 @@ protected:
                   - (2. / 3) * P * Div_par(Vi)             // Compression
             ;
 
-        if (atomic) {
-          // Include radiation and neutral interaction
-          ddt(P) -= (2. / 3) * (R   // Radiated power
-                                + E // Energy transferred to neutrals
-                               );
-        }
-
         if (volume_source) {
           // Volumetric source
 
@@ -1677,20 +1656,34 @@ protected:
           if (snb_model) {
             // SNB non-local heat flux. Also returns the Spitzer-Harm value for comparison
             // Note: Te in eV, Ne in Nnorm
-            Field2D dy_orig = mesh->getCoordinates()->dy;
-            mesh->getCoordinates()->dy *= rho_s0; // Convert distances to m
-
-            // [MK] multiply by conductivity factor so if we want double the conductivity
-            // then SNB results get scaled too
-            Div_Q_SNB = snb->divHeatFlux(Te * Tnorm, Ne * Nnorm, &Div_Q_SH) * kappa_epar_mod;
-            mesh->getCoordinates()->dy = dy_orig;
-            
-            // Normalise from eV/m^3/s
-            Div_Q_SNB /= Tnorm * Nnorm * Omega_ci;
-            Div_Q_SH /= Tnorm * Nnorm * Omega_ci;
+            rhs_timer.lap(TIME_DDT_P);
+            if (snbUpdateNeeded()) {
+              Field2D dy_orig = mesh->getCoordinates()->dy;
+              mesh->getCoordinates()->dy *= rho_s0; // Convert distances to m
+
+              // [MK] multiply by conductivity factor so if we want double the conductivity
+              // then SNB results get scaled too
+              Div_Q_SNB = snb->divHeatFlux(Te * Tnorm, Ne * Nnorm, &Div_Q_SH) * kappa_epar_mod;
+              mesh->getCoordinates()->dy = dy_orig;
+
+              // Normalise from eV/m^3/s
+              Div_Q_SNB /= Tnorm * Nnorm * Omega_ci;
+              Div_Q_SH /= Tnorm * Nnorm * Omega_ci;
+
+              if (snb_lagged) {
+                // Non-local correction to the local heat flux divergence
+                snb_correction = Div_Q_SNB + Div_par_diffusion_upwind(kappa_epar, Te);
+                Te_snb = copy(Te);
+              }
+            } else {
+              // Local heat flux at the current Te, with the lagged correction.
+              // Div_Q_SH is not updated
+              Div_Q_SNB = snb_correction - Div_par_diffusion_upwind(kappa_epar, Te);
+            }
 
             // Add to pressure equation
             ddt(P) -= (2. / 3) * Div_Q_SNB;
+            rhs_timer.lap(TIME_SNB);
           } else {
             // The standard Spitzer-Harm model
             ddt(P) += (2. / 3) * Div_par_diffusion_upwind(kappa_epar, Te);
@@ -1709,15 +1702,14 @@ protected:
           ddt(P) += ADpar * AddedDissipation(1.0, P, P, true);
         }
       }
-    }
 
-    // Switch off evolution at very low densities
-    for (auto i : ddt(Ne).getRegion(RGN_NOBNDRY)) {
-      if ((Ne[i] < 1e-5) && (ddt(Ne)[i] < 0.0)) {
-        ddt(Ne)[i] = 0.0;
-        ddt(NVi)[i] = 0.0;
-        ddt(P)[i] = 0.0;
+      if (atomic && rhs_atomic) {
+        // Include radiation and neutral interaction
+        ddt(P) -= (2. / 3) * (R   // Radiated power
+                              + E // Energy transferred to neutrals
+                             );
       }
+      rhs_timer.lap(TIME_DDT_P);
     }
 
     if (atomic) {
@@ -1738,7 +1730,6 @@ protected:
       if (rhs_explicit) {
         ddt(Nn) =
           -FV::Div_par(Nn, Vn, an, true) // Advection
-                  + S                 // Source from recombining plasma
                   - nloss * Nn        // Loss of neutrals from the system
             ;
 
@@ -1763,16 +1754,83 @@ protected:
         ddt(Nn) += D(Nn, hyper);
       }
 
-      if (evolve_nvn) {
-        // Evolving momentum of the neutral gas
+      if (rhs_atomic) {
+        ddt(Nn) += S; // Source from recombining plasma
+      }
 
-        TRACE("ddt(NVn)");
+      BoutReal ntarget = 0.0; // Neutral gas arriving at the target
+      if (rhs_explicit) {
+        // Boundary condition on fluxes
 
-        if (rhs_explicit) {
-          ddt(NVn) =
-            - FV::Div_par(NVn, Vn, an, true) // Momentum flow
-                     + F                  // Friction with plasma
-                     - nloss * NVn        // Loss of neutrals from the system
+        TRACE("Fluxes");
+
+        for (RangeIterator r = mesh->iterateBndryUpperY(); !r.isDone(); r++) {
+          int jz = 0; // Z index
+          int jy = mesh->yend;
+          // flux_ion = 0.0;
+          flux_ion =
+              0.25 * (Ne(r.ind, jy, jz) + Ne(r.ind, jy + 1, jz)) *
+              (Vi(r.ind, jy, jz) + Vi(r.ind, jy + 1, jz)) *
+              (coord->J(r.ind, jy) + coord->J(r.ind, jy + 1)) /
+              (sqrt(coord->g_22(r.ind, jy)) + sqrt(coord->g_22(r.ind, jy + 1)));
+          BoutReal flux_neut = 0.0;
+
+          for (int j = mesh->yend + 1; j < mesh->LocalNy; j++) {
+            // flux_ion += ddt(Ne)(r.ind, j, jz) * coord->J(r.ind,j) *
+            // coord->dy(r.ind,j);
+            flux_neut += ddt(Nn)(r.ind, j, jz) * coord->J(r.ind, j) *
+                         coord->dy(r.ind, j);
+
+            ddt(Ne)(r.ind, j, jz) = 0.0;
+            ddt(Nn)(r.ind, j, jz) = 0.0;
+          }
+
+          // Make sure that mass is conserved
+
+          // Total amount of neutral gas to be added
+          BoutReal nadd = flux_ion * frecycle + flux_neut + gaspuff;
+
+          // Neutral gas arriving at the target
+          ntarget =
+              (1 - fredistribute) * nadd /
+              (coord->J(r.ind, mesh->yend) * coord->dy(r.ind, mesh->yend));
+
+          ddt(Nn)(r.ind, mesh->yend, jz) += ntarget;
+
+          // Re-distribute neutrals. Sent to other processors
+          // with the scalar reduction
+          reduce_send[0] = fredistribute * nadd;
+
+          // Divide flux_ion by J so that the result in the output file has
+          // units of flux per m^2
+          flux_ion /= coord->J(mesh->xstart, mesh->yend + 1);
+        }
+
+        if (charge_exchange_escape) {
+          // Fast CX neutrals lost from plasma, summed over processors
+          for (int j = mesh->ystart; j <= mesh->yend; j++) {
+            reduce_send[1] += Dcx(mesh->xstart, j, 0) * coord->J(mesh->xstart, j) *
+                              coord->dy(mesh->xstart, j);
+            reduce_send[2] += Dcx_T(mesh->xstart, j, 0) * coord->J(mesh->xstart, j) *
+                              coord->dy(mesh->xstart, j);
+          }
+        }
+
+        // All scalars are now known. Completed at the end of rhs,
+        // overlapping with the neutral momentum and pressure equations
+        MPI_Iallreduce(reduce_send, reduce_recv, 4, MPI_DOUBLE, MPI_SUM, ycomm,
+                       &reduce_request);
+      }
+
+      if (evolve_nvn) {
+        // Evolving momentum of the neutral gas
+
+        TRACE("ddt(NVn)");
+
+        if (rhs_explicit) {
+          ddt(NVn) =
+            - FV::Div_par(NVn, Vn, an, true) // Momentum flow
+                     - nloss * NVn        // Loss of neutrals from the system
                      - Grad_par(Pn)       // Pressure gradient
               ;
         } else {
@@ -1811,6 +1869,10 @@ protected:
             ddt(NVn) += Div_par_diffusion(NVn * Dn, logPn); // Diffusion
           }
         }
+
+        if (rhs_atomic) {
+          ddt(NVn) += F; // Friction with plasma
+        }
       }
 
       if (evolve_pn) {
@@ -1823,7 +1885,6 @@ protected:
           ddt(Pn) +=
             - FV::Div_par(Pn, Vn, an, true) // Advection
                      - (2. / 3) * Pn * Div_par(Vn) // Compression
-                     + (2. / 3) * E // Energy transferred to neutrals
                      - nloss * Pn   // Loss of neutrals from the system
               ;
         }
@@ -1849,6 +1910,10 @@ protected:
           ddt(Pn) += D(Pn, hyper);
         }
 
+        if (rhs_atomic) {
+          ddt(Pn) += (2. / 3) * E; // Energy transferred to neutrals
+        }
+
         // Switch off evolution at very low densities
         // This seems to be necessary to get through initial transients
 
@@ -1861,277 +1926,1985 @@ protected:
       }
 
       if (rhs_explicit) {
-        // Boundary condition on fluxes
-
-        TRACE("Fluxes");
-
-        BoutReal nredist;
+        // Neutrals arriving at the target. Added here, once ddt(NVn)
+        // and ddt(Pn) have been calculated
         for (RangeIterator r = mesh->iterateBndryUpperY(); !r.isDone(); r++) {
           int jz = 0; // Z index
-          int jy = mesh->yend;
-          // flux_ion = 0.0;
-          flux_ion =
-              0.25 * (Ne(r.ind, jy, jz) + Ne(r.ind, jy + 1, jz)) *
-              (Vi(r.ind, jy, jz) + Vi(r.ind, jy + 1, jz)) *
-              (coord->J(r.ind, jy) + coord->J(r.ind, jy + 1)) /
-              (sqrt(coord->g_22(r.ind, jy)) + sqrt(coord->g_22(r.ind, jy + 1)));
-          BoutReal flux_neut = 0.0;
 
-          for (int j = mesh->yend + 1; j < mesh->LocalNy; j++) {
-            // flux_ion += ddt(Ne)(r.ind, j, jz) * coord->J(r.ind,j) *
-            // coord->dy(r.ind,j);
-            flux_neut += ddt(Nn)(r.ind, j, jz) * coord->J(r.ind, j) *
-                         coord->dy(r.ind, j);
+          if (evolve_nvn) {
+            // Set velocity of neutrals coming from the wall to a fraction of
+            // the Franck-Condon energy
+            BoutReal Vneut = -vwall * sqrt(3.5 / Tnorm);
+            ddt(NVn)(r.ind, mesh->yend, jz) += ntarget * Vneut;
+          }
+
+          if (evolve_pn) {
+            // Set temperature of the incoming neutrals to F-C
+            ddt(Pn)(r.ind, mesh->yend, jz) += ntarget * (3.5 / Tnorm);
+          }
+        }
+      }
+    }
+
+    rhs_timer.lap(TIME_NEUTRALS);
+
+    if (reduce_scalars) {
+      if (reduce_request == MPI_REQUEST_NULL) {
+        // Not started in the neutral model
+        MPI_Iallreduce(reduce_send, reduce_recv, 4, MPI_DOUBLE, MPI_SUM, ycomm,
+                       &reduce_request);
+      }
+      MPI_Wait(&reduce_request, MPI_STATUS_IGNORE);
+    }
+    rhs_timer.lap(TIME_COMMS);
+
+    if ((density_upstream > 0.0) && rhs_explicit && volume_source) {
+      BoutReal source = reduce_recv[3];
+      if ((source < 0.0) && density_source_positive) {
+        source = 0.0; // Don't remove particles
+      }
+      ASSERT2(std::isfinite(source));
+
+      // Scale NeSource
+      NeSource = source * NeSource0;
+    }
+
+    if (volume_source && rhs_explicit) {
+      ddt(Ne) += NeSource; // External volume source
+    }
+
+    // Switch off evolution at very low densities
+    for (auto i : ddt(Ne).getRegion(RGN_NOBNDRY)) {
+      if ((Ne[i] < 1e-5) && (ddt(Ne)[i] < 0.0)) {
+        countClamp(CLAMP_DDT_NE, i);
+        ddt(Ne)[i] = 0.0;
+        ddt(NVi)[i] = 0.0;
+        ddt(P)[i] = 0.0;
+      }
+    }
+
+    if (atomic && rhs_explicit) {
+      TRACE("Redistribution");
+
+      // Redistributed neutrals from the target processor
+      BoutReal nredist = reduce_recv[0];
+
+      // Distribute along length
+      for (int j = mesh->ystart; j <= mesh->yend; j++) {
+        // Neutrals into this cell
+        // Note: from earlier normalisation the sum ( redist_weight * J * dy )
+        // = 1 This ensures that if redist_weight is constant then the source
+        // of particles per volume is also constant.
+        BoutReal ncell = nredist * redist_weight(mesh->xstart, j);
+
+        ddt(Nn)(mesh->xstart, j, 0) += ncell;
+
+        // No momentum
+
+        if (evolve_pn) {
+          // Set temperature of the incoming neutrals to F-C
+          ddt(Pn)(mesh->xstart, j, 0) += ncell * (3.5 / Tnorm);
+        }
+      }
+
+      if (charge_exchange_escape) {
+        // Fast CX neutrals lost from plasma.
+        // These are redistributed, along with a fraction of their energy
+        BoutReal Dcx_Ntot = reduce_recv[1];
+        BoutReal Dcx_Ttot = reduce_recv[2];
+
+        // Scale the energy of the returning CX neutrals
+        Dcx_Ttot *= charge_exchange_return_fE;
+
+        // Use the normalised redistribuion weight
+        // sum ( redist_weight * J * dy ) = 1
+        for (int j = mesh->ystart; j <= mesh->yend; j++) {
+          ddt(Nn)(mesh->xstart, j, 0) +=
+              Dcx_Ntot * redist_weight(mesh->xstart, j);
+        }
+        if (evolve_pn) {
+          for (int j = mesh->ystart; j <= mesh->yend; j++) {
+            ddt(Pn)(mesh->xstart, j, 0) +=
+                Dcx_Ttot * redist_weight(mesh->xstart, j);
+          }
+        }
+      }
+    }
+    rhs_timer.lap(TIME_SOURCES);
+    return 0;
+  }
+
+  /*!
+   * Atomic rates (sources, sinks, friction and energy transfer) in
+   * cells jstart to jend. Rates are integrated over each cell
+   * using values in neighbouring cells, so Te, Ne, Vi, Tn, Vn and Nnlim2
+   * must be set in cells jstart-1 to jend+1.
+   *
+   * E must be set to zero, Rzrad allocated and gradT calculated
+   * before the first call.
+   *
+   * Cells are independent, and calculated in parallel with OpenMP
+   * using the thread_schedule option.
+   */
+  void atomicRates(int jstart, int jend, const Field3D &Tn, const Field3D &Nnlim2) {
+    Coordinates *coord = mesh->getCoordinates();
+
+    // Logarithms of Te and Ne at cell centres and lower cell faces.
+    // Face j+1 is the right face of cell j, so each face is calculated
+    // once rather than in both neighbouring cells
+    const int ny = mesh->LocalNy, nz = mesh->LocalNz;
+    log_centre.resize(mesh->LocalNx * ny * nz);
+    log_face.resize(mesh->LocalNx * ny * nz);
+    BOUT_OMP(parallel for collapse(3) schedule(runtime))
+    for (int i = 0; i < mesh->LocalNx; i++)
+      for (int j = jstart; j <= jend + 1; j++)
+        for (int k = 0; k < nz; k++) {
+          const int n = (i * ny + j) * nz + k;
+          if (j <= jend) {
+            log_centre[n] = LogState(Te(i, j, k) * Tnorm, Ne(i, j, k) * Nnorm);
+          }
+          log_face[n] = LogState(0.5 * (Te(i, j - 1, k) + Te(i, j, k)) * Tnorm,
+                                 0.5 * (Ne(i, j - 1, k) + Ne(i, j, k)) * Nnorm);
+        }
+
+    BOUT_OMP(parallel for collapse(3) schedule(runtime))
+    for (int i = 0; i < mesh->LocalNx; i++)
+      for (int j = jstart; j <= jend; j++)
+        for (int k = 0; k < mesh->LocalNz; k++) {
+
+          // Integrate rates over each cell using Simpson's rule
+          // Calculate cell centre (C), left (L) and right (R) values
+
+          BoutReal Te_C = Te(i, j, k),
+                   Te_L = 0.5 * (Te(i, j - 1, k) + Te(i, j, k)),
+                   Te_R = 0.5 * (Te(i, j, k) + Te(i, j + 1, k));
+          BoutReal Ne_C = Ne(i, j, k),
+                   Ne_L = 0.5 * (Ne(i, j - 1, k) + Ne(i, j, k)),
+                   Ne_R = 0.5 * (Ne(i, j, k) + Ne(i, j + 1, k));
+          BoutReal Vi_C = Vi(i, j, k),
+                   Vi_L = 0.5 * (Vi(i, j - 1, k) + Vi(i, j, k)),
+                   Vi_R = 0.5 * (Vi(i, j, k) + Vi(i, j + 1, k));
+          BoutReal Tn_C = Tn(i, j, k),
+                   Tn_L = 0.5 * (Tn(i, j - 1, k) + Tn(i, j, k)),
+                   Tn_R = 0.5 * (Tn(i, j, k) + Tn(i, j + 1, k));
+          BoutReal Nn_C = Nnlim2(i, j, k),
+                   Nn_L = 0.5 * (Nnlim2(i, j - 1, k) + Nnlim2(i, j, k)),
+                   Nn_R = 0.5 * (Nnlim2(i, j, k) + Nnlim2(i, j + 1, k));
+          BoutReal Vn_C = Vn(i, j, k),
+                   Vn_L = 0.5 * (Vn(i, j - 1, k) + Vn(i, j, k)),
+                   Vn_R = 0.5 * (Vn(i, j, k) + Vn(i, j + 1, k));
+
+          const int n = (i * ny + j) * nz + k;
+          const LogState &log_L = log_face[n], &log_C = log_centre[n],
+                         &log_R = log_face[n + nz];
+
+          // Jacobian (Cross-sectional area)
+          BoutReal J_C = coord->J(i, j),
+                   J_L = 0.5 * (coord->J(i, j - 1) + coord->J(i, j)),
+                   J_R = 0.5 * (coord->J(i, j) + coord->J(i, j + 1));
+
+          if (fimp > 0.0) {
+            // Impurity radiation
+
+            if (impurity_adas) {
+              BoutReal Rz_L = computeRadiatedPowerLog10(*impurity,
+                                                   log_L.log10Te,      // log10 electron temperature [eV]
+                                                   log_L.log10Ne,      // log10 electron density [m^-3]
+                                                   Ne_L * Nnorm,        // electron density [m^-3]
+                                                   fimp * Ne_L * Nnorm, // impurity density [m^-3]
+                                                   Nn_L * Nnorm);       // Neutral density [m^-3]
+
+              BoutReal Rz_C = computeRadiatedPowerLog10(*impurity,
+                                                   log_C.log10Te,      // log10 electron temperature [eV]
+                                                   log_C.log10Ne,      // log10 electron density [m^-3]
+                                                   Ne_C * Nnorm,        // electron density [m^-3]
+                                                   fimp * Ne_C * Nnorm, // impurity density [m^-3]
+                                                   Nn_C * Nnorm);       // Neutral density [m^-3]
+
+              BoutReal Rz_R = computeRadiatedPowerLog10(*impurity,
+                                                   log_R.log10Te,      // log10 electron temperature [eV]
+                                                   log_R.log10Ne,      // log10 electron density [m^-3]
+                                                   Ne_R * Nnorm,        // electron density [m^-3]
+                                                   fimp * Ne_R * Nnorm, // impurity density [m^-3]
+                                                   Nn_R * Nnorm);       // Neutral density [m^-3]
+
+              // Simpson's rule, calculate average over cell
+              Rzrad(i, j, k) = (J_L * Rz_L +
+                                4. * J_C * Rz_C +
+                                J_R * Rz_R) / (6. * J_C);
+            } else {
+              Rzrad(i, j, k) = rad->power(Te_C * Tnorm, Ne_C * Nnorm,
+                                          Ne_C * (Nnorm * fimp)); // J / m^3 / s
+            }
+            Rzrad(i, j, k) /= SI::qe * Tnorm * Nnorm * Omega_ci; // Normalise
+          }
+
+          ///////////////////////////////////////
+          // Charge exchange
+    
+    // These need initialisation outside of the if statements
+    BoutReal R_cx_L, R_cx_C, R_cx_R;
+    
+          if (charge_exchange) {
+      
+            // SOLKIT MODEL (MK 12/05/2022)
+            // CONSTANT CROSS-SECTION 3E-19m2, COLD ION/NEUTRAL AND STATIC NEUTRAL ASSUMPTION
+            if (cx_solkit) {
+              R_cx_L = Ne_L * Nn_L * (3e-19 * Nnorm * rho_s0) * Vi_L;
+
+              R_cx_C = Ne_C * Nn_C * (3e-19 * Nnorm * rho_s0) * Vi_C;
+
+              R_cx_R = Ne_R * Nn_R * (3e-19 * Nnorm * rho_s0) * Vi_R;
+
+            } else {
+            // ORIGINAL MODEL 
+              R_cx_L = Ne_L * Nn_L *
+                      hydrogen.chargeExchange(log_L) *
+                      (Nnorm / Omega_ci);
+              R_cx_C = Ne_C * Nn_C *
+                      hydrogen.chargeExchange(log_C) *
+                      (Nnorm / Omega_ci);
+              R_cx_R = Ne_R * Nn_R *
+                      hydrogen.chargeExchange(log_R) *
+                      (Nnorm / Omega_ci);
+            }
+    
+            // Ecx is energy transferred to neutrals
+            // Set to 0 if neutral temperature not evolved [MK]
+            if (evolve_pn) {
+              Ecx(i, j, k) = (3. / 2) *
+                             (J_L * (Te_L - Tn_L) * R_cx_L +
+                              4. * J_C * (Te_C - Tn_C) * R_cx_C +
+                              J_R * (Te_R - Tn_R) * R_cx_R) /
+                             (6. * J_C);
+            }
+
+            // Fcx is friction between plasma and neutrals
+            Fcx(i, j, k) = (J_L * (Vi_L - Vn_L) * R_cx_L +
+                            4. * J_C * (Vi_C - Vn_C) * R_cx_C +
+                            J_R * (Vi_R - Vn_R) * R_cx_R) /
+                           (6. * J_C);
+
+            // Dcx is a redistribution of fast neutrals due to charge exchange
+            // Acts as a sink of plasma density
+            Dcx(i, j, k) = (J_L * R_cx_L + 4. * J_C * R_cx_C + J_R * R_cx_R) /
+                           (6. * J_C);
+
+            // Energy lost from the plasma
+            // This gives the temperature of the CX neutrals when
+            // divided by Dcx
+            Dcx_T(i, j, k) = (J_L * Te_L * R_cx_L + 4. * J_C * Te_C * R_cx_C +
+                              J_R * Te_R * R_cx_R) /
+                             (6. * J_C);
+          }
+          
+          if (read_s == false) {
+              ///////////////////////////////////////
+              // Recombination
+
+              if (recombination) {
+                BoutReal R_rc_L =
+                    hydrogen.recombination(log_L) *
+                    SQ(Ne_L) * Nnorm / Omega_ci;
+                BoutReal R_rc_C =
+                    hydrogen.recombination(log_C) *
+                    SQ(Ne_C) * Nnorm / Omega_ci;
+                BoutReal R_rc_R =
+                    hydrogen.recombination(log_R) *
+                    SQ(Ne_R) * Nnorm / Omega_ci;
+
+                // Rrec is radiated energy, Erec is energy transferred to neutrals
+                // Factor of 1.09 so that recombination becomes an energy source
+                // at 5.25eV
+                Rrec(i, j, k) =
+                    (J_L * (1.09 * Te_L - 13.6 / Tnorm) * R_rc_L +
+                     4. * J_C * (1.09 * Te_C - 13.6 / Tnorm) * R_rc_C +
+                     J_R * (1.09 * Te_R - 13.6 / Tnorm) * R_rc_R) /
+                    (6. * J_C);
+                
+                if (include_erec) {
+                  Erec(i, j, k) = (3. / 2) *
+                                  (J_L * Te_L * R_rc_L + 4. * J_C * Te_C * R_rc_C +
+                                   J_R * Te_R * R_rc_R) /
+                                  (6. * J_C);
+                }
+
+                Frec(i, j, k) = (J_L * Vi_L * R_rc_L + 4. * J_C * Vi_C * R_rc_C +
+                                 J_R * Vi_R * R_rc_R) /
+                                (6. * J_C);
+
+                Srec(i, j, k) =
+                    (J_L * R_rc_L + 4. * J_C * R_rc_C + J_R * R_rc_R) /
+                    (6. * J_C);
+              }
+
+              ///////////////////////////////////////
+              // Ionisation
+
+              if (ionisation) {
+                BoutReal R_iz_L, R_iz_C, R_iz_R;
+              
+                if (iz_solkit) {
+                  R_iz_L = Ne_L * Nn_L *
+                                    hydrogen.ionisation(log_L) * Nnorm /
+                                    Omega_ci;
+                  R_iz_C = Ne_C * Nn_C *
+                                    hydrogen.ionisation(log_C) * Nnorm /
+                                    Omega_ci;
+                  R_iz_R = Ne_R * Nn_R *
+                                    hydrogen.ionisation(log_R) * Nnorm /
+                                    Omega_ci;
+                } else {
+                  R_iz_L = Ne_L * Nn_L *
+                                  hydrogen.ionisation_old(log_L) * Nnorm /
+                                  Omega_ci;
+                  R_iz_C = Ne_C * Nn_C *
+                                    hydrogen.ionisation_old(log_C) * Nnorm /
+                                    Omega_ci;
+                  R_iz_R = Ne_R * Nn_R *
+                                    hydrogen.ionisation_old(log_R) * Nnorm /
+                                    Omega_ci;
+                }
+
+                Riz(i, j, k) =
+                    (Eionize / Tnorm) *
+                    ( // Energy loss per ionisation
+                        J_L * R_iz_L + 4. * J_C * R_iz_C + J_R * R_iz_R) /
+                    (6. * J_C);
+                    
+                if (include_eiz) {
+                  Eiz(i, j, k) =
+                      -(3. / 2) *
+                      ( // Energy from neutral atom temperature
+                          J_L * Tn_L * R_iz_L + 4. * J_C * Tn_C * R_iz_C +
+                          J_R * Tn_R * R_iz_R) /
+                      (6. * J_C);
+                }
+
+                // Friction due to ionisation
+                Fiz(i, j, k) = -(J_L * Vn_L * R_iz_L + 4. * J_C * Vn_C * R_iz_C +
+                                 J_R * Vn_R * R_iz_R) /
+                               (6. * J_C);
+
+                // Plasma sink due to ionisation (negative)
+                Siz(i, j, k) =
+                    -(J_L * R_iz_L + 4. * J_C * R_iz_C + J_R * R_iz_R) /
+                    (6. * J_C);
+              
+      
+                if (atomic_debug) {
+                  // Rate diagnostics
+                  // Calculate field Siz_compare which is saved but doesn't go into other calculations
+                  R_iz_L = Ne_L * Nn_L *
+                                  hydrogen.ionisation_old(log_L) * Nnorm /
+                                  Omega_ci;
+                  R_iz_C = Ne_C * Nn_C *
+                                    hydrogen.ionisation_old(log_C) * Nnorm /
+                                    Omega_ci;
+                  R_iz_R = Ne_R * Nn_R *
+                                    hydrogen.ionisation_old(log_R) * Nnorm /
+                                    Omega_ci;
+
+                  Siz_compare(i, j, k) =
+                  -(J_L * R_iz_L + 4. * J_C * R_iz_C + J_R * R_iz_R) /
+                  (6. * J_C);
+                }
+              }
+            }
+
+          if (elastic_scattering) {
+            /////////////////////////////////////////////////////////
+            // Ion-neutral elastic scattering
+            //
+            // Post "A Review of Recent Developments in Atomic Processes for
+            // Divertors and Edge Plasmas" PSI review paper
+            //       https://arxiv.org/pdf/plasm-ph/9506003.pdf
+            // Relative velocity of two particles in a gas
+            // is sqrt(8kT/pi mu) where mu = m_A*m_B/(m_A+m_B)
+            // here ions and neutrals have same mass,
+            // and the ion temperature is used
+
+            BoutReal a0 = 3e-19; // Effective cross-section [m^2]
+
+            // Rates (normalised)
+            BoutReal R_el_L = a0 * Ne_L * Nn_L * Cs0 *
+                              sqrt((16. / PI) * Te_L) * Nnorm / Omega_ci;
+            BoutReal R_el_C = a0 * Ne_C * Nn_C * Cs0 *
+                              sqrt((16. / PI) * Te_C) * Nnorm / Omega_ci;
+            BoutReal R_el_R = a0 * Ne_R * Nn_R * Cs0 *
+                              sqrt((16. / PI) * Te_R) * Nnorm / Omega_ci;
+
+            // Elastic transfer of momentum
+            Fel(i, j, k) = (J_L * (Vi_L - Vn_L) * R_el_L +
+                            4. * J_C * (Vi_C - Vn_C) * R_el_C +
+                            J_R * (Vi_R - Vn_R) * R_el_R) /
+                           (6. * J_C);
+
+            // Elastic transfer of thermal energy
+            Eel(i, j, k) = (3. / 2) *
+                           (J_L * (Te_L - Tn_L) * R_el_L +
+                            4. * J_C * (Te_C - Tn_C) * R_el_C +
+                            J_R * (Te_R - Tn_R) * R_el_R) /
+                           (6. * J_C);
+          }
+          
+          if (include_braginskii_rt) {
+            /////////////////////////////////////////////////////////
+            // Braginskii thermal electron-ion friction as plasma energy sink
+            // gradT = Grad_par(Te) is calculated before atomicRates is called
+            
+            // Hopelessly trying to prevent issues in guard cells..
+            // Last two cells before the target use the value at yend-2.
+            // This is recalculated rather than copied, so that cells
+            // can be calculated in any order
+            int jr = j;
+            if (mesh->lastY(i) && (j >= mesh->yend - 1)) {
+              jr = mesh->yend - 2;
+            }
+            
+            BoutReal gradT_C = gradT(i, jr, k);
+            BoutReal gradT_L = 0.5 * (gradT(i, jr - 1, k) + gradT(i, jr, k));
+            BoutReal gradT_R = 0.5 * (gradT(i, jr, k) + gradT(i, jr + 1, k));
+                     
+            BoutReal E_rt_L = 0.5 * (Vi(i, jr - 1, k) + Vi(i, jr, k)) * 0.71
+                              * 0.5 * (Ne(i, jr - 1, k) + Ne(i, jr, k)) * gradT_L;
+            BoutReal E_rt_C = Vi(i, jr, k) * 0.71 * Ne(i, jr, k) * gradT_C;
+            BoutReal E_rt_R = 0.5 * (Vi(i, jr, k) + Vi(i, jr + 1, k)) * 0.71
+                              * 0.5 * (Ne(i, jr, k) + Ne(i, jr + 1, k)) * gradT_R;
+            
+            BoutReal Jr_C = coord->J(i, jr),
+                     Jr_L = 0.5 * (coord->J(i, jr - 1) + coord->J(i, jr)),
+                     Jr_R = 0.5 * (coord->J(i, jr) + coord->J(i, jr + 1));
+            
+            Ert(i, j, k) = (Jr_L * E_rt_L + 4. * Jr_C * E_rt_C + Jr_R * E_rt_R) / (6. * Jr_C);
+            // Ert(i, mesh->yend, k) = Ert(i, mesh->yend-1, k);
+            // Ert(i, mesh->ystart, k) = Ert(i, mesh->yend-1, k);
+            
+            // Ert = -Vi * 0.71 * Ne * Grad_par(Te);
+            
+          }
+          
+          if (read_r == false) {
+            if (excitation) {
+              /////////////////////////////////////////////////////////
+              // Electron-neutral excitation
+              // Note: Rates need checking
+              // Currently assuming that quantity calculated is in [eV m^3/s]
+              // MK modified this to calculate net excitation rate from AMJUEL 
+              // effective excitation energy rate minus base ionisation energy cost 13.6eV * fION  
+              // where fION is the Sawada ionisation rate in the low density (coronal) limit of 1e8 cm-3
+              // this is used because the coronal limit won't include any excited state effects which are accounted 
+              // for in the excitation energy rate already. Note functions are in m-3 hence 1e8 * 1e6
+              BoutReal R_ex_L, R_ex_C, R_ex_R;
+
+              if (ex_solkit) {
+                R_ex_L = Ne_L * Nn_L *
+                                  (hydrogen.excitation(log_L) - hydrogen.ionisation(1e8*1e6, Te_L * Tnorm) * 13.6) * Nnorm /
+                                  Omega_ci / Tnorm;
+                R_ex_C = Ne_C * Nn_C *
+                                  (hydrogen.excitation(log_C) - hydrogen.ionisation(1e8*1e6, Te_C * Tnorm) * 13.6) * Nnorm /
+                                  Omega_ci / Tnorm;
+                R_ex_R = Ne_R * Nn_R *
+                                  (hydrogen.excitation(log_R) - hydrogen.ionisation(1e8*1e6, Te_R * Tnorm) * 13.6) * Nnorm /
+                                  Omega_ci / Tnorm;
+
+                Rex(i, j, k) = (J_L * R_ex_L + 4. * J_C * R_ex_C + J_R * R_ex_R) /
+                               (6. * J_C);
+              }
+              
+              if (ex_population) {
+                // Calculate excitation rate based on Yulin Zhou's approach (Zhou 2022)
+                // Take AMJUEL rates H.12 2.1.5b through to 2.1.5e. These give you populations of excited states
+                // These are in the format Nn (excited state) / Nn (ground state) and provide up to 6th state
+                // Then use einstein coefficients from Yacora to calculate the radiation. See the paper for details.
+                
+                // The five populations share their log(T) and log(Ne) terms, and
+                // are summed with the Einstein coefficients and energy gaps
+                R_ex_L = Nn_L * excited_states.radiatedPower(log_L) / Omega_ci / Tnorm;
+                R_ex_C = Nn_C * excited_states.radiatedPower(log_C) / Omega_ci / Tnorm;
+                R_ex_R = Nn_R * excited_states.radiatedPower(log_R) / Omega_ci / Tnorm;
+                
+                Rex(i, j, k) = (J_L * R_ex_L + 4. * J_C * R_ex_C + J_R * R_ex_R) /
+                               (6. * J_C);
+                               
+              if (atomic_debug) {							 
+                // Calculate Rex the SD1D default way (HYDHEL H.2 2.1.5)
+                R_ex_L = Ne_L * Nn_L *
+                                  hydrogen.excitation_old(Te_L * Tnorm) * Nnorm /
+                                  Omega_ci / Tnorm;
+                R_ex_C = Ne_C * Nn_C *
+                                  hydrogen.excitation_old(Te_C * Tnorm) * Nnorm /
+                                  Omega_ci / Tnorm;
+                R_ex_R = Ne_R * Nn_R *
+                                  hydrogen.excitation_old(Te_R * Tnorm) * Nnorm /
+                                  Omega_ci / Tnorm;
+                
+              
+                Rex_compare(i, j, k) = (J_L * R_ex_L + 4. * J_C * R_ex_C + J_R * R_ex_R) /
+                               (6. * J_C);
+              }
+              } else {
+                // Calculate the SD1D default way
+                R_ex_L = Ne_L * Nn_L *
+                                  hydrogen.excitation_old(Te_L * Tnorm) * Nnorm /
+                                  Omega_ci / Tnorm;
+                R_ex_C = Ne_C * Nn_C *
+                                  hydrogen.excitation_old(Te_C * Tnorm) * Nnorm /
+                                  Omega_ci / Tnorm;
+                R_ex_R = Ne_R * Nn_R *
+                                  hydrogen.excitation_old(Te_R * Tnorm) * Nnorm /
+                                  Omega_ci / Tnorm;
+                                  
+                Rex(i, j, k) = (J_L * R_ex_L + 4. * J_C * R_ex_C + J_R * R_ex_R) /
+                               (6. * J_C);
+              }
+            }
+          }
+          
+          
+          // Total energy lost from system
+          // Compute only if we're not reading it from file [MK]
+          if (read_r) {
+            Rzrad(i, j, k) = 0;
+            Rrec(i, j, k) = 0;
+            Riz(i, j, k) = 0;
+            Rex(i, j, k) = 0;
+          } else {
+            R(i, j, k) = (Rzrad(i, j, k)  // Radiated power from impurities
+                         + Rrec(i, j, k) // Recombination
+                         + Riz(i, j, k)  // Ionisation
+                         + Rex(i, j, k)) * e_mod; // Excitation
+          }
+          
+          // Total energy transferred to neutrals
+          E(i, j, k) = (Ecx(i, j, k)    // Charge exchange
+                       + Erec(i, j, k) // Recombination
+                       + Eiz(i, j, k)  // ionisation
+                       + Eel(i, j, k)  // Elastic collisions
+                       + Ert(i, j, k)) * e_mod; // Braginskii RT [MK]
+          if (read_f) {
+                       // F is set to the imported value and others are zeroed [MK]
+                       F(i, j, k) = F_sk(i, j, k);
+                       Fiz(i, j, k) = 0;
+                       Fcx(i, j, k) = 0;
+                       Fel(i, j, k) = 0;
+                       Frec_sk(i, j, k) = 0;
+                       Fcx_exc(i, j, k) = 0;
+          } else {
+            // Total friction
+            F(i, j, k) =   (Frec(i, j, k)   // Recombination
+                         + Fiz(i, j, k)  // Ionisation
+                         + Fcx(i, j, k)  // Charge exchange
+                         + Fel(i, j, k)
+                         + Frec_sk(i, j, k)
+                         + Fcx_exc(i, j, k))*f_mod; // Elastic collisions
+          }
+
+          // Total sink of plasma, source of neutrals
+          // Compute only if we're not reading it from file [MK]
+          if (read_s) {
+            Srec(i, j, k) = 0;
+            Siz(i, j, k) = 0;
+          } else {
+            S(i, j, k) = (Srec(i, j, k) + Siz(i, j, k))*s_mod;
+          }
+          
+          
+          // For matching SOL-KiT thesis version, I doubled the conductivity, doubled heat input,
+          // doubled radiation and got rid of ion energy terms. Hopefully this is the same 
+          // as SOLKiT by having double power in, double out to match the double pressure we have from 
+          // having a plasma equation. [MK]
+          
+          // E(i, j, k) = E(i, j, k) * e_mod;
+          // R(i, j, k) = R(i, j, k) * e_mod; // Scale by energy mod
+          // F(i, j, k) = F(i, j, k) * f_mod; // Scale by friction mod
+          // S(i, j, k) = S(i, j, k) * s_mod; // Scale by source mod
+          
+          
+          ASSERT3(finite(R(i, j, k)));
+          ASSERT3(finite(E(i, j, k)));
+          ASSERT3(finite(F(i, j, k)));
+          ASSERT3(finite(S(i, j, k)));
+        }
+  }
+
+  /*!
+   * Quantities derived from the evolving variables: velocities and
+   * temperatures, and limited densities. Calculated in all cells,
+   * including guard cells.
+   */
+  void derivedQuantities(Field3D &Nelim, Field3D &Nnlim, Field3D &Tn) {
+    Nelim = floor(Ne, 1e-5);
+
+    Vi = NVi / Ne;
+
+    Te = 0.5 * P / Ne; // Assuming Te = Ti
+
+    // Limit in guard cells too, so coefficients are consistent between processors
+    for (auto &i : Te.getRegion("RGN_ALL")) {
+      if (Te[i] > 10.)
+        Te[i] = 10.;
+    }
+
+    if (atomic) {
+      // Includes atomic processes, neutral gas
+      Nnlim = floor(Nn, 1e-5);
+
+      if (evolve_nvn) {
+        Vn = NVn / Nnlim;
+      } else {
+        Vn = -vwall * sqrt(3.5 / Tnorm);
+        NVn = Nn * Vn;
+      }
+
+      if (evolve_pn) {
+        Tn = Pn / Nnlim;
+        // Tn = floor(Tn, 0.025/Tnorm); // Minimum tn_floor
+        Tn = floor(Tn, 1e-12);
+      } else {
+          if (tn_3ev) {
+            Tn = 3 / Tnorm; // Weak CX coupling, Tn=3eV (Franck-Condon, SOLKiT assumption). Do not use  [MK]
+          } else {
+            Tn = Te; // Strong CX coupling
+          }
+        Pn = Tn * floor(Nn, 0.0);
+        Tn = floor(Tn, tn_floor / Tnorm); // Minimum of tn_floor
+      }
+    }
+  }
+
+  /*!
+   * Preconditioner. Solves the atomic sources in each cell if
+   * atomic_precon is set, then the heat conduction
+   *
+   * @param[in] t  The simulation time
+   * @param[in] gamma   Factor in front of the Jacobian in (I - gamma*J).
+   * Related to timestep
+   * @param[in] delta   Not used here
+   */
+  int precon(BoutReal t, BoutReal gamma, BoutReal UNUSED(delta)) {
+    if (count_statistics) {
+      precon_calls++;
+    }
+
+    if (atomic && atomic_precon) {
+      atomicBlockJacobi(t, gamma);
+    }
+
+    static std::unique_ptr<InvertPar> inv = nullptr;
+    if (!inv) {
+      // Initialise parallel inversion class
+      inv = InvertPar::create();
+      inv->setCoefA(1.0);
+    }
+    if (heat_conduction) {
+      // Set the coefficient in front of Grad2_par2
+      inv->setCoefB(-(2. / 3) * gamma * kappa_epar);
+      Field3D dT = ddt(P);
+      dT.applyBoundary("neumann");
+      ddt(P) = inv->solve(dT);
+    }
+
+    if (atomic) {
+      if (evolve_pn && include_dneut) {
+        // Neutral pressure
+        inv->setCoefB(-(2. / 3) * gamma * kappa_n);
+        Field3D dT = ddt(Pn);
+        dT.applyBoundary("neumann");
+        ddt(Pn) = inv->solve(dT);
+      }
+
+      if (include_dneut) {
+        inv->setCoefB(-gamma * Dn);
+        Field3D tmp = ddt(Nn);
+        tmp.applyBoundary("neumann");
+        ddt(Nn) = inv->solve(tmp);
+      }
+    }
+
+    return 0;
+  }
+
+  /*!
+   * Evolving variables which atomic sources act on, in the order used
+   * by atomicSources() and atomicBlockJacobi()
+   */
+  std::vector<Field3D *> atomicVariables() {
+    std::vector<Field3D *> vars = {&Ne, &NVi, &P, &Nn};
+    if (evolve_nvn) {
+      vars.push_back(&NVn);
+    }
+    if (evolve_pn) {
+      vars.push_back(&Pn);
+    }
+    return vars;
+  }
+
+  /*!
+   * Fields which are set by atomicSources(), through derivedQuantities()
+   * and atomicRates(). These are saved and restored by atomicBlockJacobi()
+   * so that the preconditioner doesn't change the rhs diagnostics
+   */
+  std::vector<Field3D *> atomicOutputs() {
+    return {&Vi,   &Te,  &Vn,    &NVn, &Pn,   &gradT,
+            &Srec, &Siz, &Frec,  &Fiz, &Fcx,  &Fel,  &Frec_sk, &Fcx_exc,
+            &Rrec, &Riz, &Rzrad, &Rex, &Erec, &Eiz,  &Ecx,     &Eel,
+            &Ert,  &Dcx, &Dcx_T, &S,   &F,    &E,    &R,
+            &Siz_compare, &Rex_compare};
+  }
+
+  /*!
+   * Atomic source terms in the time derivatives of atomicVariables(),
+   * at the current state. Guard cells, including boundaries, must have
+   * been set. Overwrites the fields in atomicOutputs().
+   */
+  std::vector<Field3D> atomicSources() {
+    Field3D Nelim, Nnlim, Tn;
+    derivedQuantities(Nelim, Nnlim, Tn);
+
+    E = 0.0;
+    if (fimp > 0.0) {
+      Rzrad.allocate();
+    }
+    Field3D Nnlim2 = floor(Nn, 0.0);
+    if (include_braginskii_rt) {
+      gradT = Grad_par(Te);
+    }
+    atomicRates(mesh->ystart, mesh->yend, Tn, Nnlim2);
+    if (!evolve_nvn && neutral_f_pn) {
+      F = Grad_par(Pn);
+    }
+
+    // S and F are copied, since atomicRates writes to them in place
+    // and the result must not change at the next call
+    std::vector<Field3D> sources = {-S, -F, -(2. / 3) * (R + E), copy(S)};
+    if (evolve_nvn) {
+      sources.push_back(copy(F));
+    }
+    if (evolve_pn) {
+      sources.push_back((2. / 3) * E);
+    }
+    return sources;
+  }
+
+  /*!
+   * Block Jacobi preconditioner for the atomic sources. In each cell,
+   * solves (I - gamma * J) x = b where J is the Jacobian of the atomic
+   * sources with respect to the variables in that cell, and b is the
+   * input in ddt(). The result replaces ddt().
+   *
+   * J is calculated by finite differences, perturbing each variable in all
+   * cells at once, so coupling to neighbouring cells (through the cell
+   * edge values in atomicRates) is lumped into the cell's own block.
+   * J is only recalculated when t changes. The fields set by rhs, and
+   * the clamp counts, are the same afterwards as before.
+   */
+  void atomicBlockJacobi(BoutReal t, BoutReal gamma) {
+    std::vector<Field3D *> vars = atomicVariables();
+    const int nvar = vars.size();
+    const auto &region = Ne.getRegion(RGN_NOBNDRY);
+
+    if (t != atomic_jacobian_time) {
+      // Guard cells of the state passed to the preconditioner are not set
+      FieldGroup comms;
+      for (auto *f : vars) {
+        comms.add(*f);
+      }
+      mesh->communicate(comms);
+      for (auto *f : vars) {
+        f->applyBoundary();
+      }
+
+      // Rates set by rhs are overwritten, so are saved here
+      std::vector<Field3D *> outputs = atomicOutputs();
+      std::vector<Field3D> saved_outputs;
+      for (auto *f : outputs) {
+        saved_outputs.push_back(f->isAllocated() ? copy(*f) : *f);
+      }
+      // Clamps in the ADAS tables are counted until the next output.
+      // Those from rhs are kept, and those from perturbed states dropped
+      collectAdasClamps();
+
+      std::vector<std::vector<Field3D>> perturbed(nvar);
+      std::vector<Field3D> delta(nvar);
+      for (int v = 0; v < nvar; v++) {
+        Field3D &f = *vars[v];
+        const Field3D saved = f;
+        delta[v] = 1e-6 * abs(saved) + 1e-10;
+        f = saved + delta[v];
+        f.applyBoundary();
+        perturbed[v] = atomicSources();
+        f = saved;
+      }
+      std::vector<Field3D> base = atomicSources();
+
+      atomic_jacobian.resize(nvar * nvar * (mesh->xend - mesh->xstart + 1) *
+                             (mesh->yend - mesh->ystart + 1) * mesh->LocalNz);
+      int c = 0; // Cell number
+      for (const auto &i : region) {
+        for (int v = 0; v < nvar; v++) {
+          for (int u = 0; u < nvar; u++) {
+            atomic_jacobian[(c * nvar + u) * nvar + v] =
+                (perturbed[v][u][i] - base[u][i]) / delta[v][i];
+          }
+        }
+        c++;
+      }
+      if (atomic_jacobian_check) {
+        checkAtomicJacobian(vars);
+      }
+
+      collectAdasClamps(false);
+      for (std::size_t n = 0; n < outputs.size(); n++) {
+        *outputs[n] = saved_outputs[n];
+      }
+      atomic_jacobian_time = t;
+    }
+
+    int c = 0;
+    for (const auto &i : region) {
+      BoutReal A[6][6], x[6];
+      for (int u = 0; u < nvar; u++) {
+        x[u] = ddt(*vars[u])[i];
+        for (int v = 0; v < nvar; v++) {
+          A[u][v] = ((u == v) ? 1.0 : 0.0)
+                    - gamma * atomic_jacobian[(c * nvar + u) * nvar + v];
+        }
+      }
+      solveDense(A, x, nvar);
+      for (int u = 0; u < nvar; u++) {
+        ddt(*vars[u])[i] = x[u];
+      }
+      c++;
+    }
+  }
+
+  /*!
+   * Test of atomicBlockJacobi: compares the derivative of the neutral
+   * density source with respect to Ne in atomic_jacobian to a central
+   * difference with a larger step, in the cell on this processor where
+   * the derivative is largest. Throws if they differ by more than 1%.
+   * Called after the Jacobian is calculated, before the outputs are restored
+   */
+  void checkAtomicJacobian(const std::vector<Field3D *> &vars) {
+    const int nvar = vars.size();
+    const int u = 3, v = 0; // d(ddt(Nn)) / dNe
+
+    Field3D &f = *vars[v];
+    const Field3D saved = f;
+    const Field3D step = 1e-4 * abs(saved) + 1e-8;
+    f = saved + step;
+    f.applyBoundary();
+    const Field3D plus = atomicSources()[u];
+    f = saved - step;
+    f.applyBoundary();
+    const Field3D minus = atomicSources()[u];
+    f = saved;
+
+    BoutReal fd_max = 0.0, jacobian = 0.0;
+    int c = 0;
+    for (const auto &i : Ne.getRegion(RGN_NOBNDRY)) {
+      const BoutReal fd = (plus[i] - minus[i]) / (2. * step[i]);
+      if (fabs(fd) > fabs(fd_max)) {
+        fd_max = fd;
+        jacobian = atomic_jacobian[(c * nvar + u) * nvar + v];
+      }
+      c++;
+    }
+    output_info.write("\tAtomic Jacobian check: %e, finite difference %e\n", jacobian,
+                      fd_max);
+    if (fabs(jacobian - fd_max) > 1e-2 * fabs(fd_max)) {
+      throw BoutException("Atomic Jacobian d(ddt(Nn))/dNe = %e, but finite difference = %e",
+                          jacobian, fd_max);
+    }
+  }
+
+  /// Solve A x = b by Gaussian elimination with partial pivoting,
+  /// for n <= 6. On input x is b; A is modified. If A is singular
+  /// x is left as b
+  static void solveDense(BoutReal A[6][6], BoutReal x[6], int n) {
+    BoutReal b[6];
+    std::copy(x, x + n, b);
+    for (int k = 0; k < n; k++) {
+      int pivot = k;
+      for (int r = k + 1; r < n; r++) {
+        if (fabs(A[r][k]) > fabs(A[pivot][k])) {
+          pivot = r;
+        }
+      }
+      if (A[pivot][k] == 0.0) {
+        std::copy(b, b + n, x); // Singular. Leave unpreconditioned
+        return;
+      }
+      if (pivot != k) {
+        std::swap(A[k], A[pivot]);
+        std::swap(x[k], x[pivot]);
+      }
+      for (int r = k + 1; r < n; r++) {
+        BoutReal factor = A[r][k] / A[k][k];
+        for (int col = k; col < n; col++) {
+          A[r][col] -= factor * A[k][col];
+        }
+        x[r] -= factor * x[k];
+      }
+    }
+    for (int k = n - 1; k >= 0; k--) {
+      for (int col = k + 1; col < n; col++) {
+        x[k] -= A[k][col] * x[col];
+      }
+      x[k] /= A[k][k];
+    }
+  }
+
+  /*!
+   * When split operator is enabled, run only the explicit part
+   */
+  int convective(BoutReal t) {
+    rhs_explicit = true;
+    rhs_implicit = false;
+    rhs_atomic = !atomic_implicit;
+    update_coefficients = true;
+    return rhs(t);
+  }
+
+  /*!
+   * When split operator is enabled, run only implicit part
+   */
+  int diffusive(BoutReal t, bool linear) {
+    rhs_explicit = false;
+    rhs_implicit = true;
+    rhs_atomic = atomic_implicit;
+    update_coefficients = !linear; // Don't update coefficients in linear solve
+    return rhs(t);
+  }
+
+  /*!
+   * Solve F(u) = 0, where F is the time derivative calculated in rhs(),
+   * using pseudo-transient continuation.
+   *
+   * Each pseudo-timestep dtau takes one Newton step of the backward Euler
+   * system (I/dtau - J) du = F(u). The linear system is solved with
+   * Jacobian-free GMRES, right-preconditioned with precon(). The
+   * pseudo-timestep grows as the residual falls (switched evolution
+   * relaxation), so that the iteration tends to Newton's method.
+   *
+   * @returns true if the residual converged
+   */
+  bool solveSteadyState() {
+    TRACE("SD1D::solveSteadyState");
+
+    // Always evaluate all terms
+    rhs_explicit = rhs_implicit = true;
+    rhs_atomic = true;
+    update_coefficients = true;
+
+    // Pseudo-time is not simulation time, so the density controller
+    // state is restored afterwards, and calls are not counted
+    const BoutReal saved_error_integral = density_error_integral;
+    const BoutReal saved_error_last = density_error_last;
+    const BoutReal saved_error_lasttime = density_error_lasttime;
+    count_statistics = false;
+
+    std::vector<BoutReal> u, F, du, unew, Fnew;
+    packState(u);
+
+    BoutReal tau = 0.0; // Pseudo-time, passed to rhs()
+    steadyResidual(tau, u, F);
+    BoutReal Fnorm0 = norm(F);
+    BoutReal Fnorm = Fnorm0;
+    BoutReal dtau = steady_dtau;
+
+    output.write("\nSteady-state solve: initial residual %e\n", Fnorm0);
+    steadyReport(0, dtau, F);
+
+    bool converged = false;
+    int iter;
+    for (iter = 1; iter <= steady_maxiter; iter++) {
+      if (Fnorm < steady_atol + steady_rtol * Fnorm0) {
+        converged = true;
+        break;
+      }
+
+      // Newton step for (u - u0)/dtau = F(u)
+      int nlinear = steadyGMRES(tau, dtau, u, F, du);
+
+      unew = u;
+      axpy(1.0, du, unew);
+      steadyResidual(tau + dtau, unew, Fnew);
+      BoutReal Fnorm_new = norm(Fnew);
+
+      if (!std::isfinite(Fnorm_new) || (Fnorm_new > steady_reject_factor * Fnorm)) {
+        // Reject step and reduce pseudo-timestep. Fields calculated by
+        // rhs are reset to u, since precon() uses them
+        steadyResidual(tau, u, F);
+        dtau *= 0.25;
+        output.write("PTC %4d: rejected, residual %e. Reducing dtau to %e\n",
+                     iter, Fnorm_new, dtau);
+        if (dtau < 1e-10 * steady_dtau) {
+          break;
+        }
+        continue;
+      }
+
+      // Accept step
+      tau += dtau;
+      u.swap(unew);
+      F.swap(Fnew);
+
+      // Switched evolution relaxation: grow step as residual falls
+      BoutReal growth = Fnorm / Fnorm_new;
+      if (growth > steady_growth_max) {
+        growth = steady_growth_max;
+      }
+      Fnorm = Fnorm_new;
+      dtau = std::min(dtau * growth, steady_dtau_max);
+
+      output.write("PTC %4d: %3d linear its, ", iter, nlinear);
+      steadyReport(tau, dtau, F);
+    }
+
+    // Leave evolving fields set to the final state
+    unpackState(u);
+
+    if (converged) {
+      output.write("Steady-state converged in %d steps: residual %e\n\n",
+                   iter - 1, Fnorm);
+    } else {
+      output_warn.write(
+          "WARNING: Steady-state not converged after %d steps: residual %e\n\n",
+          iter - 1, Fnorm);
+    }
+
+    density_error_integral = saved_error_integral;
+    density_error_last = saved_error_last;
+    density_error_lasttime = saved_error_lasttime;
+    count_statistics = true;
+
+    return converged;
+  }
+
+  /// Print pseudo-time, timestep and the residual norm of each field
+  void steadyReport(BoutReal tau, BoutReal dtau, const std::vector<BoutReal> &F) {
+    output.write("tau = %e, dtau = %e, |F| = %e :", tau, dtau, norm(F));
+    const std::size_t n = F.size() / evolving.size();
+    for (std::size_t f = 0; f < evolving.size(); f++) {
+      BoutReal local = 0.0;
+      for (std::size_t i = f * n; i < (f + 1) * n; i++) {
+        local += SQ(F[i]);
+      }
+      BoutReal global;
+      MPI_Allreduce(&local, &global, 1, MPI_DOUBLE, MPI_SUM, BoutComm::get());
+      output.write(" %s %e", evolving[f].first.c_str(), sqrt(global));
+    }
+    output.write("\n");
+  }
+
+  /*!
+   * Solve (I/dtau - J) du = F with GMRES, using a finite difference
+   * approximation to the Jacobian-vector product and precon()
+   * as a right preconditioner.
+   *
+   * @returns The number of linear iterations
+   */
+  int steadyGMRES(BoutReal tau, BoutReal dtau, const std::vector<BoutReal> &u,
+                  const std::vector<BoutReal> &F, std::vector<BoutReal> &du) {
+    const int m = steady_krylov_dim;
+    const std::size_t n = u.size();
+
+    std::vector<std::vector<BoutReal>> V(m + 1), Z(m);
+    std::vector<std::vector<BoutReal>> H(m + 1, std::vector<BoutReal>(m, 0.0));
+    std::vector<BoutReal> cs(m), sn(m), g(m + 1, 0.0);
+
+    const BoutReal unorm = norm(u);
+    const BoutReal beta = norm(F);
+
+    du.assign(n, 0.0);
+    if (beta == 0.0) {
+      return 0;
+    }
+
+    V[0] = F;
+    scale(1. / beta, V[0]);
+    g[0] = beta;
+
+    std::vector<BoutReal> upert, Fpert;
+    int k = 0;
+    while (k < m) {
+      // Apply preconditioner. Inverse of (I - dtau*J)/dtau
+      steadyPrecon(tau, dtau, V[k], Z[k]);
+
+      // w = (I/dtau - J) z, with J z from finite difference of F
+      BoutReal znorm = norm(Z[k]);
+      BoutReal eps = 1e-7 * (1. + unorm) / (znorm > 0.0 ? znorm : 1.0);
+      upert = u;
+      axpy(eps, Z[k], upert);
+      steadyResidual(tau, upert, Fpert);
+
+      std::vector<BoutReal> w(n);
+      for (std::size_t i = 0; i < n; i++) {
+        w[i] = Z[k][i] / dtau - (Fpert[i] - F[i]) / eps;
+      }
+
+      // Modified Gram-Schmidt
+      for (int i = 0; i <= k; i++) {
+        H[i][k] = dot(w, V[i]);
+        axpy(-H[i][k], V[i], w);
+      }
+      H[k + 1][k] = norm(w);
+
+      V[k + 1] = w;
+      if (H[k + 1][k] > 0.0) {
+        scale(1. / H[k + 1][k], V[k + 1]);
+      }
+
+      // Apply previous Givens rotations to the new column
+      for (int i = 0; i < k; i++) {
+        BoutReal tmp = cs[i] * H[i][k] + sn[i] * H[i + 1][k];
+        H[i + 1][k] = -sn[i] * H[i][k] + cs[i] * H[i + 1][k];
+        H[i][k] = tmp;
+      }
+      // New rotation to eliminate H[k+1][k]
+      BoutReal r = sqrt(SQ(H[k][k]) + SQ(H[k + 1][k]));
+      if (r == 0.0) {
+        break; // Breakdown; use the basis so far
+      }
+      cs[k] = H[k][k] / r;
+      sn[k] = H[k + 1][k] / r;
+      H[k][k] = r;
+      H[k + 1][k] = 0.0;
+      g[k + 1] = -sn[k] * g[k];
+      g[k] = cs[k] * g[k];
+
+      k++;
+      if (fabs(g[k]) < steady_linear_rtol * beta) {
+        break;
+      }
+    }
+
+    // Back-substitute for Krylov coefficients
+    std::vector<BoutReal> y(k);
+    for (int i = k - 1; i >= 0; i--) {
+      y[i] = g[i];
+      for (int j = i + 1; j < k; j++) {
+        y[i] -= H[i][j] * y[j];
+      }
+      y[i] /= H[i][i];
+    }
+
+    for (int i = 0; i < k; i++) {
+      axpy(y[i], Z[i], du);
+    }
+    return k;
+  }
+
+  /// Set the state to u, and calculate the time derivatives F(u)
+  void steadyResidual(BoutReal tau, const std::vector<BoutReal> &u,
+                      std::vector<BoutReal> &F) {
+    unpackState(u);
+    rhs(tau);
+    packDdt(F);
+  }
+
+  /// Approximate inverse of (I/dtau - J) using the preconditioner
+  void steadyPrecon(BoutReal tau, BoutReal dtau, const std::vector<BoutReal> &v,
+                    std::vector<BoutReal> &z) {
+    unpackDdt(v);
+    precon(tau, dtau, 0.0);
+    packDdt(z);
+    scale(dtau, z);
+  }
+
+  /// Copy the evolving fields (excluding guard cells) into a vector
+  void packState(std::vector<BoutReal> &u) {
+    u.clear();
+    for (auto &f : evolving) {
+      for (const auto &i : f.second->getRegion(RGN_NOBNDRY)) {
+        u.push_back((*f.second)[i]);
+      }
+    }
+  }
+
+  /// Set the evolving fields from a vector created by packState.
+  /// Frozen coefficients are recalculated at the next rhs call
+  void unpackState(const std::vector<BoutReal> &u) {
+    std::size_t ind = 0;
+    for (auto &f : evolving) {
+      for (const auto &i : f.second->getRegion(RGN_NOBNDRY)) {
+        (*f.second)[i] = u[ind++];
+      }
+    }
+    coefficient_time = -1.0;
+  }
+
+  /// Copy the time derivatives of the evolving fields into a vector
+  void packDdt(std::vector<BoutReal> &F) {
+    F.clear();
+    for (auto &f : evolving) {
+      Field3D &dt = ddt(*f.second);
+      for (const auto &i : dt.getRegion(RGN_NOBNDRY)) {
+        F.push_back(dt[i]);
+      }
+    }
+  }
+
+  /// Set the time derivatives of the evolving fields from a vector
+  void unpackDdt(const std::vector<BoutReal> &F) {
+    std::size_t ind = 0;
+    for (auto &f : evolving) {
+      Field3D &dt = ddt(*f.second);
+      for (const auto &i : dt.getRegion(RGN_NOBNDRY)) {
+        dt[i] = F[ind++];
+      }
+    }
+  }
+
+  // Global vector operations used in the steady-state solver
 
-            ddt(Ne)(r.ind, j, jz) = 0.0;
-            ddt(Nn)(r.ind, j, jz) = 0.0;
-          }
+  static BoutReal dot(const std::vector<BoutReal> &a, const std::vector<BoutReal> &b) {
+    BoutReal local = 0.0;
+    for (std::size_t i = 0; i < a.size(); i++) {
+      local += a[i] * b[i];
+    }
+    BoutReal global;
+    MPI_Allreduce(&local, &global, 1, MPI_DOUBLE, MPI_SUM, BoutComm::get());
+    return global;
+  }
 
-          // Make sure that mass is conserved
+  static BoutReal norm(const std::vector<BoutReal> &a) { return sqrt(dot(a, a)); }
 
-          // Total amount of neutral gas to be added
-          BoutReal nadd = flux_ion * frecycle + flux_neut + gaspuff;
+  /// y += alpha * x
+  static void axpy(BoutReal alpha, const std::vector<BoutReal> &x,
+                   std::vector<BoutReal> &y) {
+    for (std::size_t i = 0; i < x.size(); i++) {
+      y[i] += alpha * x[i];
+    }
+  }
 
-          // Neutral gas arriving at the target
-          BoutReal ntarget =
-              (1 - fredistribute) * nadd /
-              (coord->J(r.ind, mesh->yend) * coord->dy(r.ind, mesh->yend));
+  static void scale(BoutReal alpha, std::vector<BoutReal> &x) {
+    for (auto &val : x) {
+      val *= alpha;
+    }
+  }
 
-          ddt(Nn)(r.ind, mesh->yend, jz) += ntarget;
+  /*!
+   * Monitor output solutions
+   */
+  int outputMonitor(BoutReal simtime, int iter, int UNUSED(NOUT)) {
 
-          if (evolve_nvn) {
-            // Set velocity of neutrals coming from the wall to a fraction of
-            // the Franck-Condon energy
-            BoutReal Vneut = -vwall * sqrt(3.5 / Tnorm);
-            ddt(NVn)(r.ind, mesh->yend, jz) += ntarget * Vneut;
-          }
+    static BoutReal mindt_alltime = 0.0; // Minimum limit over all output times
 
-          if (evolve_pn) {
-            // Set temperature of the incoming neutrals to F-C
-            ddt(Pn)(r.ind, mesh->yend, jz) += ntarget * (3.5 / Tnorm);
+    if (cfl_info) {
+      computeCflLimits();
+
+      output.write("\nTimestep limits (normalised):");
+      BoutReal mindt = 0.0;
+      for (int c = 0; c < NCFL; c++) {
+        if (cfl_limit[c] > 0.0) {
+          output.write(" %s %e", cfl_names[c].c_str(), cfl_limit[c]);
+          if ((mindt == 0.0) || (cfl_limit[c] < mindt)) {
+            mindt = cfl_limit[c];
           }
+        }
+      }
+      if ((mindt_alltime == 0.0) || (mindt < mindt_alltime)) {
+        mindt_alltime = mindt;
+      }
+      output.write("\nMinimum global limit %e\n", mindt_alltime);
+    }
 
-          // Re-distribute neutrals
-          nredist = fredistribute * nadd;
+    solverStatistics(simtime);
+    clampStatistics();
+    diagnostics->write(simtime, iter);
+    if (reduced_diagnostics || stop_on_convergence) {
+      reducedDiagnostics();
+    }
 
-          // Divide flux_ion by J so that the result in the output file has
-          // units of flux per m^2
-          flux_ion /= coord->J(mesh->xstart, mesh->yend + 1);
-        }
+    if (stop_on_convergence && steadyStateReached()) {
+      output.write("\nConverged for %d consecutive outputs. Stopping\n",
+                   stop_consecutive);
+      stopRun();
+    }
 
-        // Now broadcast redistributed neutrals to other processors
-        MPI_Comm ycomm = mesh->getYcomm(mesh->xstart); // MPI communicator
-        int np;
-        MPI_Comm_size(ycomm, &np); // Number of processors
+    if (rhs_profile || balance_info) {
+      rhs_timer.reduce(BoutComm::get());
+    }
+    if (rhs_profile) {
+      rhs_timer.print();
+    }
+    if (balance_info) {
+      loadBalanceReport();
+    }
 
-        // Broadcast from final processor (presumably with target)
-        // to all other processors
-        MPI_Bcast(&nredist, 1, MPI_DOUBLE, np - 1, ycomm);
+    if (adapt_grid && ((iter + 1) % adapt_every == 0)) {
+      adaptGrid();
+    }
+    return 0;
+  }
 
-        // Distribute along length
-        for (int j = mesh->ystart; j <= mesh->yend; j++) {
-          // Neutrals into this cell
-          // Note: from earlier normalisation the sum ( redist_weight * J * dy )
-          // = 1 This ensures that if redist_weight is constant then the source
-          // of particles per volume is also constant.
-          BoutReal ncell = nredist * redist_weight(mesh->xstart, j);
+  /*!
+   * End the simulation from outputMonitor, with exit status 0. BOUT++ v4
+   * treats a non-zero return from a monitor as an error and calls
+   * MPI_Abort, so instead the dump file is written for this output (the
+   * restart files were written before outputMonitor was called), files
+   * are closed and BOUT++ is finalised. Must be called on all processors.
+   */
+  [[noreturn]] void stopRun() {
+    dump.write();
+    diagnostics.reset();
+    BoutFinalise();
+    std::exit(0);
+  }
 
-          ddt(Nn)(mesh->xstart, j, 0) += ncell;
+  /*!
+   * Should the SNB heat flux be recalculated, rather than using the lagged
+   * correction? True if not lagged, or at least snb_lag_calls calls since
+   * the last update, or if Te has changed by more than snb_lag_tol
+   * anywhere. The SNB solve is collective, so the decision is the same
+   * on all processors.
+   */
+  bool snbUpdateNeeded() {
+    bool update = !snb_lagged || (snb_calls_since_update < 0)
+                  || (snb_calls_since_update + 1 >= snb_lag_calls);
+
+    if (!update && (snb_lag_tol > 0.0)) {
+      BoutReal change = 0.0;
+      for (const auto &i : Te.getRegion(RGN_NOBNDRY)) {
+        change = std::max(change, fabs(Te[i] - Te_snb[i]) / Te_snb[i]);
+      }
+      BoutReal max_change;
+      MPI_Allreduce(&change, &max_change, 1, MPI_DOUBLE, MPI_MAX, BoutComm::get());
+      update = max_change > snb_lag_tol;
+    }
 
-          // No momentum
+    if (update) {
+      snb_calls_since_update = 0;
+      if (snb_lagged) {
+        snb_updates++;
+      }
+    } else {
+      snb_calls_since_update++;
+    }
+    return update;
+  }
 
-          if (evolve_pn) {
-            // Set temperature of the incoming neutrals to F-C
-            ddt(Pn)(mesh->xstart, j, 0) += ncell * (3.5 / Tnorm);
-          }
-        }
+  /*!
+   * Count calls to rhs, and the internal timesteps of the solver.
+   * All calls in a step attempt are at the same time, so a call at a new
+   * time starts a new attempt. If the time is earlier than the last
+   * attempt then that attempt was rejected, either because the error
+   * test failed or the nonlinear iteration didn't converge.
+   */
+  void countRhsCall(BoutReal time) {
+    if (!count_statistics) {
+      return;
+    }
+    if (attempt_time < 0.0) {
+      // First call. Statistics are for the interval starting here
+      last_output_time = time;
+      last_output_wall_time = MPI_Wtime();
+    }
+    if (reset_solver_counters) {
+      rhs_calls = precon_calls = solver_steps = step_failures = snb_updates = 0;
+      reset_solver_counters = false;
+    }
 
-        if (charge_exchange_escape) {
-          // Fast CX neutrals lost from plasma.
-          // These are redistributed, along with a fraction of their energy
+    rhs_calls++;
+    last_call_rejected = false;
+    if (time != attempt_time) {
+      if (time < attempt_time) {
+        step_failures++;
+        last_call_rejected = true;
+      }
+      solver_steps++;
+      attempt_time = time;
+    }
+  }
 
-          BoutReal Dcx_Ntot = 0.0;
-          BoutReal Dcx_Ttot = 0.0;
-          for (int j = mesh->ystart; j <= mesh->yend; j++) {
-            Dcx_Ntot += Dcx(mesh->xstart, j, 0) * coord->J(mesh->xstart, j) *
-                        coord->dy(mesh->xstart, j);
-            Dcx_Ttot += Dcx_T(mesh->xstart, j, 0) * coord->J(mesh->xstart, j) *
-                        coord->dy(mesh->xstart, j);
-          }
+  /*!
+   * Estimate the timestep limit of an explicit method for each process,
+   * in one pass over all interior cells:
+   *  - advection, (|Vi| + cs) / dl
+   *  - plasma heat conduction, dl^2 / (2 D) with D = kappa_epar / (3 Ne)
+   *  - neutral diffusion, with D = Dn
+   *  - neutral heat conduction, with D = 2 kappa_n / (3 Nn)
+   *  - atomic sources, the timescale on which S, R and E change
+   *    Ne, Nn or P
+   * Coefficients are those from the last rhs call.
+   *
+   * Sets cfl_dt to the smallest limit in each cell, cfl_process to the
+   * process which sets it, and cfl_limit to the smallest limit of each
+   * process over all processors (0 if the process isn't included).
+   * All limits are normalised.
+   */
+  void computeCflLimits() {
+    Coordinates *coord = mesh->getCoordinates();
+    const Field2D dl = coord->dy * sqrt(coord->g_22); // Length of cells
 
-          // Now sum on all processors
-          BoutReal send[2] = {Dcx_Ntot, Dcx_Ttot};
-          BoutReal recv[2];
-          MPI_Allreduce(send, recv, 2, MPI_DOUBLE, MPI_SUM, ycomm);
-          Dcx_Ntot = recv[0];
-          Dcx_Ttot = recv[1];
+    const bool neutral_diffusion = atomic && include_dneut;
+    const bool neutral_conduction = neutral_diffusion && evolve_pn;
 
-          // Scale the energy of the returning CX neutrals
-          Dcx_Ttot *= charge_exchange_return_fE;
+    BoutReal maxinvdt[NCFL] = {}; // Maximum 1/dt on this processor
+    for (const auto &i : Ne.getRegion(RGN_NOBNDRY)) {
+      const BoutReal invdl2 = 1. / SQ(dl[i]);
+      BoutReal invdt[NCFL] = {};
 
-          // Use the normalised redistribuion weight
-          // sum ( redist_weight * J * dy ) = 1
-          for (int j = mesh->ystart; j <= mesh->yend; j++) {
-            ddt(Nn)(mesh->xstart, j, 0) +=
-                Dcx_Ntot * redist_weight(mesh->xstart, j);
-          }
-          if (evolve_pn) {
-            for (int j = mesh->ystart; j <= mesh->yend; j++) {
-              ddt(Pn)(mesh->xstart, j, 0) +=
-                  Dcx_Ttot * redist_weight(mesh->xstart, j);
-            }
-          }
+      // Sound speed as in the numerical dissipation, sqrt(gamma_sound * 2 * Te)
+      invdt[CFL_ADVECTION] = (fabs(Vi[i]) + sqrt(gamma_sound * P[i] / Ne[i])) / dl[i];
+      if (heat_conduction) {
+        invdt[CFL_CONDUCTION] = (2. / 3) * kappa_epar[i] / Ne[i] * invdl2;
+      }
+      if (neutral_diffusion) {
+        invdt[CFL_NEUTRAL_DIFFUSION] = 2. * Dn[i] * invdl2;
+      }
+      if (neutral_conduction) {
+        invdt[CFL_NEUTRAL_CONDUCTION] =
+            (4. / 3) * kappa_n[i] / std::max(Nn[i], 1e-5) * invdl2;
+      }
+      if (atomic) {
+        invdt[CFL_ATOMIC] =
+            std::max({fabs(S[i]) / std::max(Ne[i], 1e-5),
+                      fabs(S[i]) / std::max(Nn[i], 1e-5),
+                      (fabs(R[i]) + fabs(E[i])) / std::max(P[i], 1e-10)});
+      }
+
+      int stiffest = 0;
+      for (int c = 0; c < NCFL; c++) {
+        maxinvdt[c] = std::max(maxinvdt[c], invdt[c]);
+        if (invdt[c] > invdt[stiffest]) {
+          stiffest = c;
         }
       }
+      cfl_dt[i] = (invdt[stiffest] > 0.0) ? 1. / invdt[stiffest] : 0.0;
+      cfl_process[i] = stiffest;
+    }
+
+    BoutReal maxinvdt_all[NCFL];
+    MPI_Allreduce(maxinvdt, maxinvdt_all, NCFL, MPI_DOUBLE, MPI_MAX, BoutComm::get());
+    for (int c = 0; c < NCFL; c++) {
+      cfl_limit[c] = (maxinvdt_all[c] > 0.0) ? 1. / maxinvdt_all[c] : 0.0;
     }
-    return 0;
   }
 
   /*!
-   * Preconditioner. Solves the heat conduction
-   *
-   * @param[in] t  The simulation time
-   * @param[in] gamma   Factor in front of the Jacobian in (I - gamma*J).
-   * Related to timestep
-   * @param[in] delta   Not used here
+   * Count a cell where a floor or limit was applied
    */
-  int precon(BoutReal UNUSED(t), BoutReal gamma, BoutReal UNUSED(delta)) {
+  void countClamp(int clamp, const Ind3D &i) {
+    if (!count_statistics) {
+      return;
+    }
+    clamp_count[clamp] += 1.0;
+    if (clamp_masks) {
+      clamp_mask[clamp][i] += 1.0;
+    }
+  }
 
-    static std::unique_ptr<InvertPar> inv = nullptr;
-    if (!inv) {
-      // Initialise parallel inversion class
-      inv = InvertPar::create();
-      inv->setCoefA(1.0);
+  /*!
+   * Count the interior cells where clamped(i) is true
+   */
+  template <typename F>
+  void countClamps(int clamp, F clamped) {
+    for (const auto &i : Ne.getRegion(RGN_NOBNDRY)) {
+      if (clamped(i)) {
+        countClamp(clamp, i);
+      }
     }
-    if (heat_conduction) {
-      // Set the coefficient in front of Grad2_par2
-      inv->setCoefB(-(2. / 3) * gamma * kappa_epar);
-      Field3D dT = ddt(P);
-      dT.applyBoundary("neumann");
-      ddt(P) = inv->solve(dT);
+  }
+
+  /*!
+   * Add the number of times the ADAS impurity rate tables were clamped
+   * to the counts, if add is true, then reset the tables' counts
+   */
+  void collectAdasClamps(bool add = true) {
+    if (!impurity_adas) {
+      return;
+    }
+    for (auto &rate : impurity->get_rate_coefficients()) {
+      if (add) {
+        clamp_count[CLAMP_ADAS_TE] += rate.second->get_te_clamped();
+        clamp_count[CLAMP_ADAS_NE] += rate.second->get_ne_clamped();
+      }
+      rate.second->reset_clamp_counts();
     }
+  }
 
-    if (atomic) {
-      if (evolve_pn && include_dneut) {
-        // Neutral pressure
-        inv->setCoefB(-(2. / 3) * gamma * kappa_n);
-        Field3D dT = ddt(Pn);
-        dT.applyBoundary("neumann");
-        ddt(Pn) = inv->solve(dT);
+  /*!
+   * Sum the number of clamped cells over processors, and add the
+   * number of times the ADAS impurity rate tables were clamped.
+   * Called at each output, then counts are reset.
+   */
+  void clampStatistics() {
+    collectAdasClamps();
+
+    MPI_Allreduce(clamp_count, clamp_total, NCLAMP, MPI_DOUBLE, MPI_SUM,
+                  BoutComm::get());
+
+    if (clamp_info) {
+      output.write("\nClamped cells (summed over rhs calls):");
+      for (int c = 0; c < NCLAMP; c++) {
+        if (clamp_total[c] > 0.0) {
+          output.write(" %s %.0f", clamp_names[c].c_str(), clamp_total[c]);
+        }
       }
+      output.write("\n");
+    }
 
-      if (include_dneut) {
-        inv->setCoefB(-gamma * Dn);
-        Field3D tmp = ddt(Nn);
-        tmp.applyBoundary("neumann");
-        ddt(Nn) = inv->solve(tmp);
+    if (clamp_masks) {
+      for (int c = 0; c < NCLAMP_CELL; c++) {
+        clamp_fraction[c] = clamp_mask[c] / std::max(rhs_calls, 1);
+        clamp_mask[c] = 0.0;
       }
     }
 
-    return 0;
+    for (auto &count : clamp_count) {
+      count = 0.0;
+    }
   }
 
   /*!
-   * When split operator is enabled, run only the explicit part
+   * Calculate solver statistics for the output interval which ended at
+   * simtime, print them if solver_info is set, then reset the counters.
+   * The time derivatives are evaluated at each output, after the solver
+   * has stepped past it. This call is at an earlier time than the last
+   * step, so is not counted as a rejected step.
    */
-  int convective(BoutReal t) {
-    rhs_explicit = true;
-    rhs_implicit = false;
-    update_coefficients = true;
-    return rhs(t);
+  void solverStatistics(BoutReal simtime) {
+    if (last_call_rejected && (attempt_time == simtime)) {
+      step_failures--;
+      solver_steps--;
+    }
+
+    const int accepted = solver_steps - step_failures;
+    mean_timestep = (accepted > 0) ? (simtime - last_output_time) / accepted : 0.0;
+
+    const BoutReal wall_time = MPI_Wtime();
+    wall_per_simtime = (simtime > last_output_time)
+                           ? (wall_time - last_output_wall_time) * Omega_ci /
+                                 (simtime - last_output_time)
+                           : 0.0;
+
+    if (solver_info) {
+      output.write("\nSolver: %d rhs calls, %d precon calls, %d steps "
+                   "(%d rejected), mean timestep %e s\n",
+                   rhs_calls, precon_calls, solver_steps, step_failures,
+                   mean_timestep / Omega_ci);
+      output.write("        %.1f rhs calls per step, wall time per simulated "
+                   "time %e\n",
+                   (accepted > 0) ? static_cast<BoutReal>(rhs_calls) / accepted : 0.0,
+                   wall_per_simtime);
+      if (snb_lagged) {
+        output.write("        %d SNB updates\n", snb_updates);
+      }
+    }
+
+    // Counters are reset at the next rhs call rather than here,
+    // so that these values are written to the dump file
+    reset_solver_counters = true;
+    last_output_time = simtime;
+    last_output_wall_time = wall_time;
   }
 
   /*!
-   * When split operator is enabled, run only implicit part
+   * Calculate reduced diagnostics from the current state: volume integrals
+   * of sources and sinks, target fluxes, upstream and target values, and
+   * the front position. Must be called on all processors.
+   *
+   * Powers are per unit cross-section area at the upstream boundary [W/m^2],
+   * so the target power is multiplied by the area expansion.
    */
-  int diffusive(BoutReal t, bool linear) {
-    rhs_explicit = false;
-    rhs_implicit = true;
-    update_coefficients = !linear; // Don't update coefficients in linear solve
-    return rhs(t);
+  void reducedDiagnostics() {
+    Coordinates *coord = mesh->getCoordinates();
+
+    // Profiles of interior cells on all processors, upstream to target
+    const std::vector<BoutReal> edges = globalCellEdges();
+    const std::vector<BoutReal> J = gatherY(coord->J);
+    const std::vector<BoutReal> Te_y = gatherY(Te), Ne_y = gatherY(Ne);
+    const std::vector<BoutReal> P_y = gatherY(P), NVi_y = gatherY(NVi);
+    const std::vector<BoutReal> R_y = gatherY(R), E_y = gatherY(E), F_y = gatherY(F);
+    const std::vector<BoutReal> Rzrad_y = gatherY(Rzrad);
+    const std::vector<BoutReal> Siz_y = gatherY(Siz), Srec_y = gatherY(Srec);
+    const int n = J.size();
+
+    // Sum of f * J * dl / J_upstream, normalised
+    auto integral = [&](const std::vector<BoutReal> &f) {
+      BoutReal sum = 0.0;
+      for (int i = 0; i < n; i++) {
+        sum += f[i] * J[i] * (edges[i + 1] - edges[i]);
+      }
+      return sum / J[0];
+    };
+
+    // Conversions from normalised volume integrals
+    const BoutReal to_power = SI::qe * Tnorm * Nnorm * Omega_ci * rho_s0; // W/m^2
+    const BoutReal to_particles = Nnorm * Omega_ci * rho_s0; // m^-2 s^-1
+
+    // Sources are only gathered if used. volume_source is the same on
+    // all processors, so all take part in the gather
+    if (volume_source) {
+      power_input = 1.5 * integral(gatherY(PeSource)) * to_power;
+      particle_input = integral(gatherY(NeSource)) * to_particles;
+    } else {
+      power_input = powerflux * to_power;
+      particle_input = 0.0;
+    }
+    power_radiated = integral(R_y) * to_power;
+    power_impurity = integral(Rzrad_y) * to_power;
+    power_neutrals = integral(E_y) * to_power;
+
+    ionisation_rate = -integral(Siz_y) * to_particles; // Siz is negative
+    recombination_rate = integral(Srec_y) * to_particles;
+
+    // Target values, on the last processor in y
+    BoutReal target[4] = {0.0, 0.0, 0.0, 0.0};
+    if (mesh->lastY(mesh->xstart)) {
+      const int x = mesh->xstart, y = mesh->yend;
+      target[0] = 0.5 * (Te(x, y, 0) + Te(x, y + 1, 0));
+      target[1] = 0.5 * (Ne(x, y, 0) + Ne(x, y + 1, 0));
+      target[2] = flux_ion;
+      target[3] = coord->J(x, y + 1);
+    }
+    BoutReal target_sum[4];
+    MPI_Allreduce(target, target_sum, 4, MPI_DOUBLE, MPI_SUM, BoutComm::get());
+
+    target_te = target_sum[0] * Tnorm;
+    target_ne = target_sum[1] * Nnorm;
+    target_flux = target_sum[2] * Nnorm * Cs0;
+    power_target = sheath_gamma * SI::qe * target_te * target_flux * target_sum[3] / J[0];
+
+    upstream_te = Te_y[0] * Tnorm;
+    upstream_ne = Ne_y[0] * Nnorm;
+
+    radiated_fraction = (power_input > 0.0) ? power_radiated / power_input : 0.0;
+    power_residual =
+        (power_input > 0.0)
+            ? (power_input - power_target - power_radiated - power_neutrals) / power_input
+            : 0.0;
+
+    // Friction integrated along the field, relative to upstream total pressure
+    BoutReal friction = 0.0;
+    for (int i = 0; i < n; i++) {
+      friction += F_y[i] * (edges[i + 1] - edges[i]);
+    }
+    momentum_loss_fraction = friction / (P_y[0] + SQ(NVi_y[0]) / Ne_y[0]);
+
+    // Distance from the target to the first cell, going upstream,
+    // in which Te is above front_te
+    front_position = 0.0;
+    for (int i = n - 1; i >= 0; i--) {
+      if (Te_y[i] * Tnorm > front_te) {
+        front_position = (edges[n] - 0.5 * (edges[i] + edges[i + 1])) * rho_s0;
+        break;
+      }
+    }
+    if (target_te > front_te) {
+      front_position = 0.0; // Attached: no cold region
+    }
   }
 
   /*!
-   * Monitor output solutions
+   * Test whether the solution has stopped changing. Called at each
+   * output, this calculates the maximum change in Ne, P and Nn since the
+   * last output, relative to the maximum of each. The solution is steady
+   * once these are below tolerances, and the power balance residual
+   * is small, for stop_consecutive outputs in a row.
+   * Must be called on all processors, after reducedDiagnostics().
    */
-  int outputMonitor(BoutReal UNUSED(simtime), int UNUSED(iter), int UNUSED(NOUT)) {
+  bool steadyStateReached() {
+    const bool first = !Ne_last.isAllocated();
+
+    BoutReal local[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    if (!first) {
+      for (const auto &i : Ne.getRegion(RGN_NOBNDRY)) {
+        local[0] = std::max(local[0], fabs(Ne[i] - Ne_last[i]));
+        local[1] = std::max(local[1], fabs(Ne[i]));
+        local[2] = std::max(local[2], fabs(P[i] - P_last[i]));
+        local[3] = std::max(local[3], fabs(P[i]));
+        if (atomic) {
+          // Nn is not evolved or allocated otherwise
+          local[4] = std::max(local[4], fabs(Nn[i] - Nn_last[i]));
+          local[5] = std::max(local[5], fabs(Nn[i]));
+        }
+      }
+    }
+    BoutReal global[6];
+    MPI_Allreduce(local, global, 6, MPI_DOUBLE, MPI_MAX, BoutComm::get());
 
-    static BoutReal maxinvdt_alltime = 0.0; // Max 1/dt over all output times
+    Ne_last = copy(Ne);
+    P_last = copy(P);
+    if (atomic) {
+      Nn_last = copy(Nn);
+    }
+    if (first) {
+      converged_outputs = 0;
+      return false;
+    }
 
-    ///////////////////////////////////////////////////
-    // Check velocities for CFL information
+    change_ne = (global[1] > 0.0) ? global[0] / global[1] : 0.0;
+    change_p = (global[3] > 0.0) ? global[2] / global[3] : 0.0;
+    change_nn = (global[5] > 0.0) ? global[4] / global[5] : 0.0;
 
-    if (cfl_info) {
-      // Calculate the maximum velocity, including cell centres
-      // and edges.
+    bool converged = (change_ne < stop_rtol_ne) && (change_p < stop_rtol_p)
+                     && (change_nn < stop_rtol_nn);
+    if (stop_power_residual > 0.0) {
+      converged = converged && (fabs(power_residual) < stop_power_residual);
+    }
 
-      Coordinates *coord = mesh->getCoordinates();
+    if (converged) {
+      converged_outputs++;
+    } else {
+      converged_outputs = 0;
+    }
+    output.write("\nConvergence: Ne %e, P %e, Nn %e, power residual %e (%d/%d)\n",
+                 change_ne, change_p, change_nn, power_residual, converged_outputs,
+                 stop_consecutive);
+    return converged_outputs >= stop_consecutive;
+  }
 
-      BoutReal maxabsvc = 0.0; // Maximum absolute velocity + sound speed
-      BoutReal maxinvdt = 0.0; // Maximum 1/dt
+  /*!
+   * Print the time spent in rhs on each processor since the last output,
+   * and estimate the cost of each cell. The atomic physics time is
+   * distributed between cells in proportion to the neutral density if
+   * balance_by_nn is set.
+   *
+   * BOUT++ requires the same number of cells on each y processor, so
+   * the partition which balances the cost is only a suggestion. Also
+   * printed is the number of y processors (NYPE) with equal partitions
+   * beyond which adding processors reduces the estimated time by < 10%.
+   */
+  void loadBalanceReport() {
+    rhs_wall_time = rhs_timer.localTotal();
+    atomic_wall_time = rhs_timer.local(TIME_ATOMIC);
+
+    MPI_Comm ycomm = mesh->getYcomm(mesh->xstart);
+    int nype;
+    MPI_Comm_size(ycomm, &nype);
+
+    // Estimated cost of each cell on this processor
+    const int ncell = mesh->yend - mesh->ystart + 1;
+    BoutReal nnsum = 0.0;
+    if (atomic && balance_by_nn) {
       for (int j = mesh->ystart; j <= mesh->yend; j++) {
-        BoutReal g = 5. / 3;
+        nnsum += std::max(Nn(mesh->xstart, j, 0), 0.0);
+      }
+    }
+    Field2D cost(0.0);
+    for (int j = mesh->ystart; j <= mesh->yend; j++) {
+      if (nnsum > 0.0) {
+        cost(mesh->xstart, j) =
+            (rhs_wall_time - atomic_wall_time) / ncell +
+            atomic_wall_time * std::max(Nn(mesh->xstart, j, 0), 0.0) / nnsum;
+      } else {
+        cost(mesh->xstart, j) = rhs_wall_time / ncell;
+      }
+    }
+    std::vector<BoutReal> cells = gatherY(cost);
+    const int ny = cells.size();
+    BoutReal total = 0.0;
+    for (const auto &c : cells) {
+      total += c;
+    }
+
+    BoutReal maxtime;
+    MPI_Allreduce(&rhs_wall_time, &maxtime, 1, MPI_DOUBLE, MPI_MAX, ycomm);
+    load_imbalance = (total > 0.0) ? maxtime * nype / total : 1.0;
+
+    output.write("\nrhs time: %e s (atomic %e s). Load imbalance (max/mean): %.3f\n",
+                 rhs_wall_time, atomic_wall_time, load_imbalance);
+
+    if (total <= 0.0) {
+      return;
+    }
+
+    // Contiguous partition with approximately equal cost on each processor
+    std::vector<int> start = {0};
+    BoutReal cumulative = 0.0;
+    for (int j = 0; j < ny; j++) {
+      if ((static_cast<int>(start.size()) < nype) &&
+          (cumulative + 0.5 * cells[j] > start.size() * total / nype)) {
+        start.push_back(j);
+      }
+      cumulative += cells[j];
+    }
+    output.write("Balanced partition: ");
+    for (std::size_t p = 0; p < start.size(); p++) {
+      int end = (p + 1 < start.size()) ? start[p + 1] : ny;
+      output.write("%d ", end - start[p]);
+    }
+    output.write("cells. Estimated imbalance: %.3f\n",
+                 maxPartCost(cells, start) * nype / total);
+
+    // Equal partitions, for each number of processors which divides ny
+    int best_nype = 1;
+    BoutReal best_time = total;
+    for (int n = 2; n <= ny; n++) {
+      if (ny % n != 0) {
+        continue;
+      }
+      std::vector<int> equal;
+      for (int p = 0; p < n; p++) {
+        equal.push_back(p * ny / n);
+      }
+      // Stop when more processors reduce the time by less than 10%
+      BoutReal time = maxPartCost(cells, equal);
+      if (time > 0.9 * best_time) {
+        break;
+      }
+      best_nype = n;
+      best_time = time;
+    }
+    output.write("Suggested NYPE: %d. Estimated rhs time %e s, efficiency %.2f\n",
+                 best_nype, best_time, total / (best_nype * best_time));
+  }
+
+  /// Maximum over partitions of the summed cell cost
+  /// Each partition starts at the given cell index
+  static BoutReal maxPartCost(const std::vector<BoutReal> &cells,
+                              const std::vector<int> &start) {
+    BoutReal result = 0.0;
+    for (std::size_t p = 0; p < start.size(); p++) {
+      int end = (p + 1 < start.size()) ? start[p + 1] : cells.size();
+      BoutReal sum = 0.0;
+      for (int j = start[p]; j < end; j++) {
+        sum += cells[j];
+      }
+      result = std::max(result, sum);
+    }
+    return result;
+  }
+
+  /*!
+   * Redistribute grid cells to equidistribute the gradients of
+   * temperature, density, and with atomic physics the neutral density
+   * and radiated power. The number of cells is unchanged.
+   *
+   * Evolving variables are remapped conserving their volume integrals,
+   * and the time solver is restarted from the remapped state.
+   */
+  void adaptGrid() {
+    Coordinates *coord = mesh->getCoordinates();
+
+    std::vector<BoutReal> edges = globalCellEdges();
+
+    // Te is calculated from the current state, rather than
+    // the last call to rhs
+    std::vector<std::vector<BoutReal>> profiles = {gatherY(0.5 * P / Ne),
+                                                   gatherY(Ne)};
+    if (atomic) {
+      profiles.push_back(gatherY(Nn));
+      profiles.push_back(gatherY(R));
+    }
 
-        // cell centre
-        BoutReal cs = sqrt(g * P(0, j, 0) / Ne(0, j, 0)); // Sound speed
+    std::vector<BoutReal> new_edges = equidistribute(
+        edges, gradientMonitor(edges, profiles, adapt_alpha, adapt_smoothing,
+                               adapt_min_fraction));
 
-        BoutReal vcs = abs(Vi(0, j, 0)) + cs;
-        if (vcs > maxabsvc)
-          maxabsvc = vcs;
+    // Remap evolving variables, weighted by the Jacobian so that
+    // particles, momentum and energy are conserved
+    std::vector<BoutReal> J = gatherY(coord->J);
+    for (auto &var : evolving) {
+      scatterY(remapConservative(edges, gatherY(*var.second), J, new_edges),
+               *var.second);
+    }
 
-        BoutReal dl =
-            coord->dy(0, j) * sqrt(coord->g_22(0, j)); // Length of cell
-        if (vcs / dl > maxinvdt)
-          maxinvdt = vcs / dl;
+    setGrid(new_edges);
 
-        // cell left
-        BoutReal p = 0.5 * (P(0, j - 1, 0) + P(0, j, 0));
-        BoutReal n = 0.5 * (Ne(0, j - 1, 0) + Ne(0, j, 0));
-        cs = sqrt(g * p / n);
-        vcs = abs(0.5 * (Vi(0, j - 1, 0) + Vi(0, j, 0))) + cs;
-        if (vcs > maxabsvc)
-          maxabsvc = vcs;
+    // Boundary conditions and guard cells are set in the next rhs call
+    solver->resetInternalFields();
 
-        dl = 0.5 * (coord->dy(0, j) * sqrt(coord->g_22(0, j)) +
-                    coord->dy(0, j - 1) * sqrt(coord->g_22(0, j - 1)));
+    BoutReal dlmin = new_edges[1] - new_edges[0];
+    BoutReal dlmax = dlmin;
+    for (std::size_t i = 1; i < new_edges.size() - 1; i++) {
+      dlmin = std::min(dlmin, new_edges[i + 1] - new_edges[i]);
+      dlmax = std::max(dlmax, new_edges[i + 1] - new_edges[i]);
+    }
+    output.write("Adapted grid: cell length %e - %e m\n", dlmin * rho_s0,
+                 dlmax * rho_s0);
+  }
 
-        if (vcs / dl > maxinvdt)
-          maxinvdt = vcs / dl;
+  /*!
+   * Set the evolving variables from the files of another run, which
+   * may have a different number of cells, cell spacing or length.
+   *
+   * Cells are matched by their position as a fraction of the length,
+   * so the upstream and target ends of both grids coincide. Values are
+   * remapped conserving their integrals, weighted by the old Jacobian.
+   */
+  void importRun() {
+    std::vector<std::string> names;
+    for (auto &var : evolving) {
+      names.push_back(var.first);
+    }
+    ImportedProfiles old =
+        importProfiles(import_path, import_prefix, names, {"density_error_integral"});
 
-        // Cell right
-        p = 0.5 * (P(0, j + 1, 0) + P(0, j, 0));
-        n = 0.5 * (Ne(0, j + 1, 0) + Ne(0, j, 0));
-        cs = sqrt(g * p / n);
-        vcs = abs(0.5 * (Vi(0, j + 1, 0) + Vi(0, j, 0))) + cs;
-        if (vcs > maxabsvc)
-          maxabsvc = vcs;
+    std::vector<BoutReal> edges = globalCellEdges();
+    const BoutReal length = edges.back();
+    for (auto &edge : edges) {
+      edge /= length;
+    }
 
-        dl = 0.5 * (coord->dy(0, j) * sqrt(coord->g_22(0, j)) +
-                    coord->dy(0, j + 1) * sqrt(coord->g_22(0, j + 1)));
+    for (auto &var : evolving) {
+      auto it = old.fields.find(var.first);
+      if (it == old.fields.end()) {
+        output_warn.write("\t%s not in %s. Using the initial profile\n",
+                          var.first.c_str(), import_path.c_str());
+        continue;
+      }
+      scatterY(remapConservative(old.edges, it->second, old.J, edges), *var.second);
+    }
 
-        if (vcs / dl > maxinvdt)
-          maxinvdt = vcs / dl;
+    if (density_upstream > 0.0) {
+      auto it = old.scalars.find("density_error_integral");
+      if (it != old.scalars.end()) {
+        density_error_integral = it->second;
       }
+    }
+
+    coefficient_time = -1.0; // State changed outside the time solver
 
-      // Get maximum over the domain
-      BoutReal maxabsvc_all;
-      BoutReal maxinvdt_all;
+    output.write("\tImported %d cells from %s onto %d cells\n",
+                 static_cast<int>(old.J.size()), import_path.c_str(),
+                 static_cast<int>(edges.size()) - 1);
+  }
 
-      MPI_Allreduce(&maxabsvc, &maxabsvc_all, 1, MPI_DOUBLE, MPI_MAX,
-                    BoutComm::get());
-      MPI_Allreduce(&maxinvdt, &maxinvdt_all, 1, MPI_DOUBLE, MPI_MAX,
-                    BoutComm::get());
+  /*!
+   * Set the grid to the given global cell edges. Input profiles
+   * are remapped by position from the initial grid, so they are
+   * not diffused by repeated remapping.
+   */
+  void setGrid(const std::vector<BoutReal> &edges) {
+    Coordinates *coord = mesh->getCoordinates();
 
-      if (maxinvdt_all > maxinvdt_alltime)
-        maxinvdt_alltime = maxinvdt_all;
+    // Area is remapped by length, sources and weights by volume
+    std::vector<BoutReal> length(ref_J.size(), 1.0);
+    scatterY(remapConservative(ref_edges, ref_J, length, edges), coord->J);
+    coord->J.applyBoundary("neumann");
+    mesh->communicate(coord->J);
 
-      output.write("\nLocal max |v|+cs: %e Global max |v|+cs: %e\n", maxabsvc,
-                   maxabsvc_all);
-      output.write("Local CFL limit: %e Global limit: %e\n", 1. / maxinvdt,
-                   1. / maxinvdt_all);
-      output.write("Minimum global CFL limit %e\n", 1. / maxinvdt_alltime);
+    if (volume_source) {
+      Field2D &nesource = (density_upstream > 0.0) ? NeSource0 : NeSource;
+      scatterY(remapConservative(ref_edges, ref_NeSource, ref_J, edges), nesource);
+      scatterY(remapConservative(ref_edges, ref_PeSource, ref_J, edges), PeSource);
     }
-    return 0;
+    scatterY(remapConservative(ref_edges, ref_redist_weight, ref_J, edges),
+             redist_weight);
+    scatterY(remapConservative(ref_edges, ref_dneut, length, edges), dneut);
+    dneut.applyBoundary("neumann");
+    mesh->communicate(dneut);
+
+    setCellEdges(edges);
+    coord->geometry();
+
+    dy4 = SQ(SQ(coord->dy));
+    dy_adapt = coord->dy;
+
+    // Quantities calculated on the old grid are recalculated
+    // at the next rhs call
+    coefficient_time = -1.0;
+    snb_calls_since_update = -1;
+    atomic_jacobian_time = -1.0;
+
+    // Changes since the last output can't be compared between grids
+    Ne_last = P_last = Nn_last = Field3D();
   }
 
 private:
@@ -2140,6 +3913,7 @@ private:
 	std::string ex_rate;
 	std::string dn_model;
   std::string cx_model;
+  bool iz_solkit, ex_solkit, ex_population, dn_solkit, cx_solkit;
   std::string custom_file;
   bool atomic_debug;
   bool dn_debug;
@@ -2162,6 +3936,85 @@ private:
   
   bool cfl_info; // Print additional information on CFL limits
 
+  // Processes whose explicit timestep limits are calculated by computeCflLimits
+  enum {
+    CFL_ADVECTION,          // Flow and sound waves
+    CFL_CONDUCTION,         // Plasma heat conduction
+    CFL_NEUTRAL_DIFFUSION,  // Neutral gas diffusion
+    CFL_NEUTRAL_CONDUCTION, // Neutral heat conduction
+    CFL_ATOMIC,             // Atomic sources and sinks
+    NCFL
+  };
+  const std::string cfl_names[NCFL] = {"advection", "conduction", "neutral_diffusion",
+                                       "neutral_conduction", "atomic"};
+  BoutReal cfl_limit[NCFL] = {}; // Smallest limit of each process, all processors
+  Field3D cfl_dt;      // Smallest timestep limit in each cell
+  Field3D cfl_process; // Process which sets cfl_dt
+
+  bool balance_info;  // Print load balance information?
+  bool balance_by_nn; // Distribute atomic cost between cells by neutral density?
+  BoutReal rhs_wall_time, atomic_wall_time; // Time in rhs since last output [s]
+  BoutReal load_imbalance; // Ratio of maximum to mean rhs time over processors
+
+  int rhs_exchanges; // Number of guard cell exchanges in the last rhs call
+
+  // Solver statistics, over the last output interval
+  bool solver_info;                   // Print solver statistics?
+  int rhs_calls{0}, precon_calls{0};  // Number of calls to rhs and precon
+  int solver_steps{0};                // Internal timesteps attempted
+  int step_failures{0};               // Rejected timesteps
+  BoutReal mean_timestep{0.0};        // Mean accepted timestep (normalised)
+  BoutReal wall_per_simtime{0.0};     // Wall time per simulated time [s/s]
+  BoutReal attempt_time{-1.0};        // Time of the last step attempt. < 0 before the first call
+  bool last_call_rejected{false};     // Was the last step attempt counted as rejected?
+  bool reset_solver_counters{false};  // Reset counters at the next rhs call?
+  bool count_statistics{true};        // Count calls and clamps? Not in the steady-state solve
+  BoutReal last_output_time{0.0};     // Simulation time at the last output
+  BoutReal last_output_wall_time{0.0}; // MPI_Wtime() at the last output
+
+  // Floors and limits applied in rhs, which are counted. Cell clamps
+  // come first, so that they can have masks
+  enum {
+    CLAMP_NE,     // Ne floored at 1e-10
+    CLAMP_P,      // P floored at 1e-10
+    CLAMP_NN,     // Nn floored at 1e-10
+    CLAMP_TE,     // Te limited to 10 (normalised)
+    CLAMP_TN,     // Neutral temperature limited to tn_floor
+    CLAMP_DDT_NE, // Plasma evolution switched off where Ne < 1e-5
+    NCLAMP_CELL,
+    CLAMP_ADAS_TE = NCLAMP_CELL, // ADAS table Te out of range
+    CLAMP_ADAS_NE,               // ADAS table Ne out of range
+    NCLAMP
+  };
+  const std::string clamp_names[NCLAMP] = {"ne", "p", "nn", "te", "tn", "ddt_ne",
+                                           "adas_te", "adas_ne"};
+  bool clamp_info;  // Print counts at each output?
+  bool clamp_masks; // Save the fraction of rhs calls each cell was clamped?
+  BoutReal clamp_count[NCLAMP] = {}; // Since the last output, this processor
+  BoutReal clamp_total[NCLAMP] = {}; // Over the last output interval, all processors
+  Field3D clamp_mask[NCLAMP_CELL];   // Number of times each cell was clamped
+  Field3D clamp_fraction[NCLAMP_CELL]; // Fraction of rhs calls, in the last output interval
+
+  // Sections of rhs which are timed. Time between calls to rhs_timer.lap()
+  // is added to the section given.
+  enum {
+    TIME_DERIVED,      // Derived quantities Te, Vi etc.
+    TIME_COMMS,        // Waiting for communications
+    TIME_COEFFICIENTS, // Transport coefficients
+    TIME_BOUNDARY,     // Sheath boundary and density controller
+    TIME_ATOMIC,       // Atomic rates
+    TIME_DDT_NE,       // ddt(Ne)
+    TIME_DDT_NVI,      // ddt(NVi)
+    TIME_DDT_P,        // ddt(P), except SNB
+    TIME_SNB,          // SNB non-local heat flux
+    TIME_NEUTRALS,     // Neutral gas equations
+    TIME_SOURCES       // Volume sources and neutral redistribution
+  };
+  SectionTimer rhs_timer{{"derived", "comms", "coefficients", "boundary",
+                          "atomic", "ddt_ne", "ddt_nvi", "ddt_p", "snb",
+                          "neutrals", "sources"}};
+  bool rhs_profile; // Save and print rhs_timer results?
+
   // Normalisation parameters
   BoutReal Tnorm, Nnorm, Bnorm, AA;
   BoutReal Cs0, Omega_ci, rho_s0, tau_e0, mi_me;
@@ -2176,6 +4029,9 @@ private:
   bool evolve_nvn; // Evolve neutral momentum?
   bool evolve_pn;  // Evolve neutral pressure?
 
+  /// The evolving fields, in the order they were added to the solver
+  std::vector<std::pair<std::string, Field3D *>> evolving;
+
   /////////////////////////////////////////////////////////////////
   // Diffusion and viscosity coefficients
 
@@ -2194,6 +4050,13 @@ private:
   bool snb_model;       // Use the SNB model for heat conduction?
   HeatFluxSNB *snb;
   Field3D Div_Q_SH, Div_Q_SNB; // Divergence of heat flux from Spitzer-Harm and SNB
+  bool snb_lagged;            // Reuse the SNB correction between rhs calls?
+  int snb_lag_calls;          // Maximum rhs calls between SNB updates
+  BoutReal snb_lag_tol;       // Update if Te changes by more than this fraction
+  int snb_calls_since_update{-1}; // Negative before the first update
+  int snb_updates{0};         // SNB updates since the last output
+  Field3D snb_correction;     // Div_Q_SNB minus local divergence at the last update
+  Field3D Te_snb;             // Te at the last update
   
   bool charge_exchange; // Charge exchange between plasma and neutrals. Doesn't
                         // affect neutral diffusion
@@ -2238,6 +4101,8 @@ private:
   Field3D R; // Radiated power
 
   UpdatedRadiatedPower hydrogen; // Atomic rates
+  ExcitedStatePopulations excited_states; // Hydrogen n = 2 to 6 populations
+  std::vector<LogState> log_centre, log_face; // Logs of Te and Ne in atomicRates
 
   BoutReal fimp;             // Impurity fraction (of Ne)
   bool impurity_adas;        // True if using ImpuritySpecies, false if using
@@ -2267,6 +4132,30 @@ private:
 
   BoutReal flux_ion; // Flux of ions to target (output)
 
+  // Reduced diagnostics, calculated at each output. Powers in W/m^2 of
+  // upstream area, particle rates in m^-2 s^-1, temperatures in eV
+  bool reduced_diagnostics;
+  BoutReal front_te; // Temperature defining the front [eV]
+  BoutReal power_input{0.0}, power_radiated{0.0}, power_impurity{0.0},
+      power_neutrals{0.0};
+  BoutReal power_target{0.0}; // Sheath heat flux
+  BoutReal radiated_fraction{0.0}; // power_radiated / power_input
+  BoutReal power_residual{0.0}; // (input - target - radiated - neutrals) / input
+  BoutReal particle_input{0.0}, ionisation_rate{0.0}, recombination_rate{0.0};
+  BoutReal target_flux{0.0}; // Ion flux per m^2 of target
+  BoutReal momentum_loss_fraction{0.0}; // Integrated friction / upstream total pressure
+  BoutReal upstream_te{0.0}, upstream_ne{0.0}, target_te{0.0}, target_ne{0.0};
+  BoutReal front_position{0.0}; // Distance from target to front_te [m]
+
+  // Early termination when steady
+  bool stop_on_convergence;
+  BoutReal stop_rtol_ne, stop_rtol_p, stop_rtol_nn; // Relative change per output
+  BoutReal stop_power_residual; // Tolerance on power_residual
+  int stop_consecutive;         // Converged outputs needed to stop
+  int converged_outputs{0};     // Consecutive converged outputs so far
+  Field3D Ne_last, P_last, Nn_last; // At the last output
+  BoutReal change_ne{0.0}, change_p{0.0}, change_nn{0.0}; // Relative changes
+
   // Re-distribution of recycled neutrals
   Field2D redist_weight;  // Weighting used to decide redistribution
   BoutReal fredistribute; // Fraction of recycled neutrals re-distributed along
@@ -2314,7 +4203,45 @@ private:
   ///////////////////////////////////////////////////////////////
   // Splitting into implicit and explicit
   bool rhs_implicit, rhs_explicit; // Enable implicit and explicit parts
+  bool rhs_atomic;                 // Enable atomic source terms
+  bool atomic_implicit; // Atomic sources in the implicit part with split_operator?
+  bool atomic_precon;   // Include atomic sources in the preconditioner?
+  bool atomic_jacobian_check; // Test the atomic Jacobian?
+  BoutReal atomic_jacobian_time{-1.0}; // Time at which atomic_jacobian was calculated
+  std::vector<BoutReal> atomic_jacobian; // Atomic source Jacobian in each cell
   bool update_coefficients;        // Re-calculate diffusion coefficients
+
+  std::unique_ptr<DiagnosticWriter> diagnostics; // Output of diagnostic fields
+  bool freeze_coefficients; // Only re-calculate at the first call at each time?
+  BoutReal coefficient_time{-1.0}; // Time at which coefficients were calculated
+
+  ///////////////////////////////////////////////////////////////
+  // Steady-state solver (pseudo-transient continuation)
+  bool steady_state;           // Solve for steady state before time integration?
+  BoutReal steady_dtau;        // Initial pseudo-timestep
+  BoutReal steady_dtau_max;    // Maximum pseudo-timestep
+  BoutReal steady_growth_max;  // Maximum pseudo-timestep growth per step
+  BoutReal steady_reject_factor; // Maximum residual growth in an accepted step
+  int steady_maxiter;          // Maximum number of pseudo-timesteps
+  BoutReal steady_atol, steady_rtol; // Tolerances on residual norm
+  int steady_krylov_dim;       // Maximum GMRES iterations per step
+  BoutReal steady_linear_rtol; // Relative tolerance of linear solve
+
+  ///////////////////////////////////////////////////////////////
+  // Adaptive grid
+  bool adapt_grid;              // Redistribute cells at output times?
+  int adapt_every;              // Outputs between adaptations
+  BoutReal adapt_alpha;         // Weight of gradients in monitor function
+  int adapt_smoothing;          // Smoothing passes of monitor function
+  BoutReal adapt_min_fraction;  // Minimum cell size relative to uniform
+  Field2D dy_adapt;             // Adapted grid spacing, saved for restarts
+  std::vector<BoutReal> ref_edges; // Cell edges of the initial grid
+  std::vector<BoutReal> ref_J, ref_NeSource, ref_PeSource, ref_redist_weight,
+      ref_dneut; // Input profiles on the initial grid
+
+  // Import of starting profiles from another run
+  std::string import_path;   // Directory of files, or empty
+  std::string import_prefix; // File name before the processor number
 };
 
 BOUTMAIN(SD1D);
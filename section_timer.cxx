@@ -0,0 +1,91 @@
+/*
+    This file is part of SD1D.
+
+    SD1D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    SD1D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with SD1D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "section_timer.hxx"
+
+#include <output.hxx>
+
+#include <utility>
+
+SectionTimer::SectionTimer(std::vector<std::string> names)
+    : last(clock::now()), names(std::move(names)) {
+  const std::size_t n = this->names.size();
+  accumulated.assign(n, 0.0);
+  local_time.assign(n, 0.0);
+  min_time.assign(n, 0.0);
+  mean_time.assign(n, 0.0);
+  max_time.assign(n, 0.0);
+}
+
+void SectionTimer::reduce(MPI_Comm comm) {
+  const int n = names.size();
+  int np;
+  MPI_Comm_size(comm, &np);
+
+  local_time = accumulated;
+
+  // Minimum is the maximum of the negated times, so that
+  // only two reductions are needed
+  std::vector<BoutReal> send(2 * n), recv(2 * n);
+  for (int i = 0; i < n; i++) {
+    send[i] = accumulated[i];
+    send[n + i] = -accumulated[i];
+  }
+  MPI_Allreduce(send.data(), recv.data(), 2 * n, MPI_DOUBLE, MPI_MAX, comm);
+  for (int i = 0; i < n; i++) {
+    max_time[i] = recv[i];
+    min_time[i] = -recv[n + i];
+  }
+
+  MPI_Allreduce(accumulated.data(), mean_time.data(), n, MPI_DOUBLE, MPI_SUM, comm);
+  for (auto &t : mean_time) {
+    t /= np;
+  }
+
+  accumulated.assign(n, 0.0);
+}
+
+void SectionTimer::addToDump(Datafile &dump, const std::string &prefix) {
+  for (std::size_t i = 0; i < names.size(); i++) {
+    dump.addRepeat(min_time[i], prefix + names[i] + "_min");
+    dump.addRepeat(mean_time[i], prefix + names[i] + "_mean");
+    dump.addRepeat(max_time[i], prefix + names[i] + "_max");
+  }
+}
+
+void SectionTimer::print() const {
+  BoutReal total = 0.0;
+  for (const auto &t : mean_time) {
+    total += t;
+  }
+
+  output.write("\n%-16s %10s %10s %10s %7s\n", "Section", "min [s]", "mean [s]",
+               "max [s]", "mean %");
+  for (std::size_t i = 0; i < names.size(); i++) {
+    output.write("%-16s %10.3e %10.3e %10.3e %6.1f%%\n", names[i].c_str(),
+                 min_time[i], mean_time[i], max_time[i],
+                 (total > 0.0) ? 100. * mean_time[i] / total : 0.0);
+  }
+}
+
+BoutReal SectionTimer::localTotal() const {
+  BoutReal total = 0.0;
+  for (const auto &t : local_time) {
+    total += t;
+  }
+  return total;
+}
@@ -0,0 +1,92 @@
+/*
+  Low overhead wall-clock timing of consecutive sections of code
+
+    This file is part of SD1D.
+
+    SD1D is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    SD1D is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with SD1D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SECTION_TIMER_H__
+#define __SECTION_TIMER_H__
+
+#include <mpi.h>
+
+#include <bout_types.hxx>
+#include <datafile.hxx>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/*!
+ * Accumulates the wall time spent in a sequence of code sections.
+ * The time between consecutive calls to lap() is added to the
+ * section passed to lap(), so sections don't need to be scoped:
+ *
+ *   timer.start();
+ *   ... calculate A ...
+ *   timer.lap(A);
+ *   ... calculate B ...
+ *   timer.lap(B);
+ *
+ * Accumulated times are reduced over processors with reduce(),
+ * which also resets them.
+ */
+class SectionTimer {
+public:
+  /// @param[in] names  The name of each section, indexed by the
+  ///                   section number passed to lap()
+  explicit SectionTimer(std::vector<std::string> names);
+
+  /// Start timing. Time before this is not counted
+  void start() { last = clock::now(); }
+
+  /// Add the time since the last call to start() or lap() to a section
+  void lap(int section) {
+    clock::time_point now = clock::now();
+    accumulated[section] += std::chrono::duration<BoutReal>(now - last).count();
+    last = now;
+  }
+
+  /// Calculate the minimum, mean and maximum of the accumulated times
+  /// over processors, then reset the accumulated times to zero.
+  /// Must be called on all processors in comm
+  void reduce(MPI_Comm comm);
+
+  /// Add time series of the minimum, mean and maximum to a dump file,
+  /// named <prefix><section name>_min, _mean and _max
+  void addToDump(Datafile &dump, const std::string &prefix);
+
+  /// Print the times from the last reduce()
+  void print() const;
+
+  /// Time in a section on this processor, from the last reduce()
+  BoutReal local(int section) const { return local_time[section]; }
+
+  /// Time in all sections on this processor, from the last reduce()
+  BoutReal localTotal() const;
+
+private:
+  using clock = std::chrono::steady_clock;
+  clock::time_point last; ///< Time of the last start() or lap()
+
+  std::vector<std::string> names;
+  std::vector<BoutReal> accumulated; ///< Since the last reduce()
+
+  /// Results of the last reduce(). Not resized after construction,
+  /// because addresses are passed to the dump file
+  std::vector<BoutReal> local_time, min_time, mean_time, max_time;
+};
+
+#endif // __SECTION_TIMER_H__
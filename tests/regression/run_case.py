@@ -0,0 +1,191 @@
+#!/usr/bin/env python
+#
+# Run one SD1D case for a few outputs, recording performance metrics and
+# comparing the final profiles to a stored reference.
+#
+# Usage: run_case.py --exe path/to/sd1d --case case-01 --work dir
+#                    [--reference refs/case-01.json] [--nout 5] [--update]
+#                    [--run-only] [option=value ...]
+#
+# Any option=value arguments are passed to SD1D. With --run-only the
+# test passes if SD1D runs without error, and no reference is used.
+#
+# Metrics recorded in <work>/metrics.json:
+#   wall_time     Wall time of the whole run [s]
+#   rhs_calls     Total calls to the RHS function
+#   cvode_steps   CVODE internal steps (if the solver is CVODE)
+#   linear_iters  CVODE linear iterations (if the solver is CVODE)
+#   peak_rss_kb   Peak resident set size [kB]
+#   precon_calls, solver_steps, step_failures
+#                 Totals of SD1D's solver statistics
+#
+# Exit codes: 0 pass, 1 fail, 77 skipped (the case's solver is not in this
+# BOUT++ build, or there is no reference to compare to). With --update the
+# reference is (over)written from this run.
+
+import argparse
+import json
+import os
+import re
+import resource
+import shutil
+import subprocess
+import sys
+import time
+
+from boutdata import collect
+from boutdata.data import BoutOptionsFile
+import numpy as np
+
+SKIP = 77
+
+# Profiles compared to the reference, if they are in the output
+PROFILES = ["Ne", "NVi", "P", "Nn", "NVn", "Pn"]
+
+parser = argparse.ArgumentParser(description="SD1D regression test")
+parser.add_argument("--exe", required=True, help="SD1D executable")
+parser.add_argument("--case", required=True, help="Case directory containing BOUT.inp")
+parser.add_argument("--work", required=True, help="Directory to run in")
+parser.add_argument("--reference", help="Reference JSON file")
+parser.add_argument("--nout", type=int, default=5, help="Number of outputs")
+parser.add_argument("--rtol", type=float, default=1e-3,
+                    help="Tolerance on profiles, relative to the maximum of each")
+parser.add_argument("--max-calls-ratio", type=float, default=1.2,
+                    help="Fail if RHS calls exceed the reference by this factor")
+parser.add_argument("--max-wall-ratio", type=float, default=0.0,
+                    help="Fail if wall time exceeds the reference by this factor. "
+                    "Not checked if <= 0, since wall time depends on the machine")
+parser.add_argument("--update", action="store_true", help="Write the reference")
+parser.add_argument("--run-only", action="store_true",
+                    help="Only check that the run succeeds")
+parser.add_argument("options", nargs="*", help="Options passed to SD1D")
+args = parser.parse_args()
+
+exe = os.path.abspath(args.exe)
+work = os.path.abspath(args.work)
+
+# Start from a clean copy of the case
+if os.path.exists(work):
+    shutil.rmtree(work)
+shutil.copytree(args.case, work, ignore=shutil.ignore_patterns("*.nc", "BOUT.log.*"))
+
+# Run in the directory containing the executable, so that the
+# atomic data (json_database) can be found
+command = [exe, "-d", work, "nout={}".format(args.nout), "solver:diagnose=true"]
+command += args.options
+print(" ".join(command))
+
+start = time.time()
+result = subprocess.run(command, cwd=os.path.dirname(exe),
+                        stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                        universal_newlines=True)
+wall_time = time.time() - start
+
+with open(os.path.join(work, "output.txt"), "w") as f:
+    f.write(result.stdout)
+
+if result.returncode != 0:
+    print(result.stdout[-3000:])
+    # Messages from the BOUT++ solver factory when the case's solver
+    # type was not compiled in
+    try:
+        solver = str(BoutOptionsFile(os.path.join(work, "BOUT.inp"))["solver"]["type"])
+    except KeyError:
+        solver = "cvode"
+    missing = (r"Could not find '{0}'|No such solver exists in this build, type: {0}\b"
+               .format(re.escape(solver)))
+    if re.search(missing, result.stdout):
+        print("SKIP: solver {} not available".format(solver))
+        sys.exit(SKIP)
+    print("FAIL: SD1D exited with code {}".format(result.returncode))
+    sys.exit(1)
+
+metrics = {
+    "wall_time": wall_time,
+    "peak_rss_kb": resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss,
+    "rhs_calls": int(np.sum(collect("ncalls", path=work, info=False))),
+}
+
+# Solver statistics saved by SD1D for each output interval
+for name in ["precon_calls", "solver_steps", "step_failures"]:
+    try:
+        metrics[name] = int(np.sum(collect(name, path=work, info=False)))
+    except ValueError:
+        pass  # Older versions of SD1D
+
+# CVODE diagnostics are cumulative, so the last line gives the totals
+cvode = re.findall(r"CVODE: nsteps (\d+), nfevals \d+, nniters \d+, npevals \d+, nliters (\d+)",
+                   result.stdout)
+if cvode:
+    metrics["cvode_steps"] = int(cvode[-1][0])
+    metrics["linear_iters"] = int(cvode[-1][1])
+
+profiles = {}
+for name in PROFILES:
+    try:
+        profiles[name] = collect(name, path=work, tind=-1, info=False).flatten().tolist()
+    except ValueError:
+        pass  # Not evolved in this case
+
+with open(os.path.join(work, "metrics.json"), "w") as f:
+    json.dump(metrics, f, indent=2)
+
+for key, value in sorted(metrics.items()):
+    print("{:14s} {}".format(key, value))
+
+if args.run_only:
+    print("PASS: run completed")
+    sys.exit(0)
+
+if args.update:
+    if os.path.dirname(args.reference):
+        os.makedirs(os.path.dirname(args.reference), exist_ok=True)
+    with open(args.reference, "w") as f:
+        json.dump({"nout": args.nout, "metrics": metrics, "profiles": profiles}, f)
+    print("Written reference {}".format(args.reference))
+    sys.exit(0)
+
+if not args.reference or not os.path.exists(args.reference):
+    print("SKIP: no reference. Create one with --update")
+    sys.exit(SKIP)
+
+with open(args.reference) as f:
+    reference = json.load(f)
+
+if reference["nout"] != args.nout:
+    print("FAIL: reference has nout = {}. Recreate it with --update".format(reference["nout"]))
+    sys.exit(1)
+
+success = True
+
+for name, ref in reference["profiles"].items():
+    ref = np.array(ref)
+    if name not in profiles:
+        print("FAIL: {} missing".format(name))
+        success = False
+        continue
+    value = np.array(profiles[name])
+    if value.shape != ref.shape:
+        print("FAIL: {} shape {} != {}".format(name, value.shape, ref.shape))
+        success = False
+        continue
+    error = np.max(np.abs(value - ref)) / max(np.max(np.abs(ref)), 1e-30)
+    print("{:14s} relative error {:.3e}".format(name, error))
+    if not error < args.rtol:
+        print("FAIL: {} differs from reference".format(name))
+        success = False
+
+ref_metrics = reference["metrics"]
+for key in sorted(metrics):
+    if key in ref_metrics and ref_metrics[key] > 0:
+        print("{:14s} ratio to reference {:.3f}".format(key, metrics[key] / ref_metrics[key]))
+
+if metrics["rhs_calls"] > args.max_calls_ratio * ref_metrics["rhs_calls"]:
+    print("FAIL: RHS calls increased")
+    success = False
+
+if args.max_wall_ratio > 0 and metrics["wall_time"] > args.max_wall_ratio * ref_metrics["wall_time"]:
+    print("FAIL: wall time increased")
+    success = False
+
+sys.exit(0 if success else 1)
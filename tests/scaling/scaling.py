@@ -0,0 +1,88 @@
+#!/usr/bin/env python
+#
+# Hybrid MPI + OpenMP scaling study. For each grid size, runs a case on a
+# fixed number of cores, divided between y processors (MPI ranks) and
+# threads per rank, and records the wall time per RHS evaluation.
+#
+# Usage: scaling.py --exe path/to/sd1d [--case case-01] [--cores 64]
+#                   [--ny 200 1000 5000] [--nout 2] [--mpirun mpirun]
+#
+# Each run uses mesh:ny, NYPE and sd1d:num_threads set on the command
+# line. Only numbers of ranks which divide ny are used. Results are
+# printed as a table and written to scaling.json in the work directory.
+
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import time
+
+from boutdata import collect
+import numpy as np
+
+parser = argparse.ArgumentParser(description="SD1D hybrid scaling study")
+parser.add_argument("--exe", required=True, help="SD1D executable")
+parser.add_argument("--case", default="case-01", help="Case directory containing BOUT.inp")
+parser.add_argument("--work", default="scaling", help="Directory to run in")
+parser.add_argument("--cores", type=int, default=os.cpu_count(),
+                    help="Total cores, shared between ranks and threads")
+parser.add_argument("--ny", type=int, nargs="+", default=[200, 1000, 5000],
+                    help="Grid sizes along the field line")
+parser.add_argument("--nout", type=int, default=2, help="Number of outputs")
+parser.add_argument("--schedule", default="static",
+                    help="Thread schedule: static, dynamic or guided")
+parser.add_argument("--mpirun", default="mpirun", help="MPI launcher")
+args = parser.parse_args()
+
+exe = os.path.abspath(args.exe)
+work = os.path.abspath(args.work)
+
+results = []
+for ny in args.ny:
+    ranks = 1
+    while ranks <= args.cores:
+        if ny % ranks != 0:
+            ranks *= 2
+            continue
+        threads = args.cores // ranks
+
+        path = os.path.join(work, "ny{}_np{}_nt{}".format(ny, ranks, threads))
+        if os.path.exists(path):
+            shutil.rmtree(path)
+        shutil.copytree(args.case, path, ignore=shutil.ignore_patterns("*.nc", "BOUT.log.*"))
+
+        command = [args.mpirun, "-np", str(ranks), exe, "-d", path,
+                   "nout={}".format(args.nout), "NYPE={}".format(ranks),
+                   "mesh:ny={}".format(ny), "sd1d:num_threads={}".format(threads),
+                   "sd1d:thread_schedule={}".format(args.schedule)]
+        print(" ".join(command))
+
+        env = dict(os.environ, OMP_NUM_THREADS=str(threads))
+        start = time.time()
+        result = subprocess.run(command, cwd=os.path.dirname(exe), env=env,
+                                stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                                universal_newlines=True)
+        wall_time = time.time() - start
+
+        with open(os.path.join(path, "output.txt"), "w") as f:
+            f.write(result.stdout)
+        if result.returncode != 0:
+            print("  failed with code {}".format(result.returncode))
+            ranks *= 2
+            continue
+
+        rhs_calls = int(np.sum(collect("ncalls", path=path, info=False)))
+        results.append({"ny": ny, "ranks": ranks, "threads": threads,
+                        "wall_time": wall_time, "rhs_calls": rhs_calls,
+                        "us_per_rhs": 1e6 * wall_time / max(rhs_calls, 1)})
+        ranks *= 2
+
+print("\n{:>6s} {:>6s} {:>8s} {:>10s} {:>10s} {:>12s}".format(
+    "ny", "ranks", "threads", "wall [s]", "rhs calls", "us per rhs"))
+for r in results:
+    print("{ny:6d} {ranks:6d} {threads:8d} {wall_time:10.2f} {rhs_calls:10d} "
+          "{us_per_rhs:12.1f}".format(**r))
+
+with open(os.path.join(work, "scaling.json"), "w") as f:
+    json.dump(results, f, indent=2)